@@ -12,6 +12,27 @@
 #include "math.h"
 #include "stdlib.h"
 #include "stdint.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <utime.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
 
 
 // const definitions
@@ -28,6 +49,7 @@ const int32_t ID_FKT_METADET=16;
 const int32_t ID_FKT_METAABSC=17;
 const int32_t ID_FKT_LSIN=18;
 const int32_t ID_FKT_ATAN=22;
+const int32_t ID_FKT_FORMULA=30;
 
 const char COLORCOLLECTIONDIR[]="COLORCOLLECTION\\";
 
@@ -46,9 +68,356 @@ const int32_t MAXRGBITERS=64;
 const int32_t MAXINTANZ=32;
 const int32_t ID_FAERBUNG_INTERVALL=2;
 
+// number of adjacent pixels evaluated together in calc
+const int32_t VECLEN=8;
+// sectionally defined functions: blend both sides if more than
+// 1/DIVERGENCEBLEND of the recent blocks had diverging lanes
+const int32_t DIVERGENCEBLEND=4;
+const int32_t DIVERGENCEWINDOW=256;
+
+// upper limit of worker threads in calc
+const int32_t MAXTHREADS=256;
+
+// warm start: tiles of WARMTILE x WARMTILE pixels (power of 2)
+// traversed along a Hilbert curve, shortest warm transient
+const int32_t WARMTILE=16;
+const int32_t WARMMIN=8;
+
+// supersampling: most samples per pixel, default thresholds on the
+// exponent and on a color channel between neighbouring pixels
+const int32_t MAXAASAMPLES=64;
+const double AALAMBDA=1.0;
+const int32_t AAFARBE=96;
+
+// exponent sketch of calc: logarithmic buckets of relative width
+// SKETCHGAMMA for either sign from SKETCHMIN in magnitude on
+const double SKETCHMIN=1E-6;
+const double SKETCHGAMMA=1.02;
+const int32_t SKETCHBINS=1100;
+// AUTOCOLOR: intervals between the quantiles AUTORAND and 1-AUTORAND,
+// colors from the ramps up to 0 (order) and above 0 (chaos)
+const int32_t AUTOINTERVALLE=12;
+const double AUTORAND=0.005;
+const int32_t AUTONEG[][3]={ {0,0,48},{0,64,160},{0,160,224},{96,224,160},{255,240,96},{255,255,255} };
+const int32_t AUTOPOS[][3]={ {96,32,96},{0,0,0} };
+
+// tile pyramid: edge of a tile (multiple of 4), levels below the full
+// size the tile server computes on demand, port and cache of the server,
+// seconds a connection may take to send its request
+const int32_t PYRAMIDTILE=256;
+const int32_t PYRAMIDTIEFER=12;
+const int32_t TILEPORT=8080;
+const int32_t TILECACHEMB=256;
+const int32_t TILETIMEOUT=5;
+
+// walk gating: thumbnail of 1/gatediv size and iterations, neighbouring
+// pixels whose RGB values differ by more than GATEKANTE form an edge
+const int32_t GATEDIV=4;
+const int32_t GATEMINLEN=16;
+const int32_t GATEKANTE=24;
+
+// phases of an image that are timed
+enum {
+	PHASE_TRANSIENT=0,
+	PHASE_COMPUTE,
+	PHASE_COLORING,
+	PHASE_SAVE,
+	ANZPHASES
+};
+
+// hardware performance counters of the profiling mode
+enum {
+	PERF_CYCLES=0,
+	PERF_INSTR,
+	PERF_BRANCHES,
+	PERF_BRANCHMISS,
+	PERF_CACHEMISS,
+	PERF_FP, // raw event, only if its code is given
+	ANZPERF
+};
+
+// precision tiers of sin/cos in calc, stored in the .par file
+enum {
+	PRECISION_REFERENCE=0, // libm
+	PRECISION_DOUBLE, // fastsin polynomial
+	PRECISION_FLOAT, // fastsin polynomial evaluated in float, orbit still double
+	PRECISION_TABLE, // interpolated lookup table
+	ANZPRECISION
+};
+const int32_t SINTABLEN=4096; // power of 2
+
+// instruction set variants of the hot kernels, chosen at startup
+enum {
+	ISA_SSE2=0,
+	ISA_AVX2, // with FMA
+	ISA_AVX512,
+	ANZISA
+};
+
+// batch mode: manifest line length, default memory limit in MB
+const int32_t MAXBATCHLINE=2048;
+const int32_t BATCHMEMMB=1024;
+
+// guided search: longest sequence, default journal
+const int32_t MAXSUCHSEQ=16;
+const char SUCHJOURNAL[]="_search.jnl";
+const char SUCHPAR[]="_search.par";
+
+// cost estimate: rows sampled and blocks of VECLEN pixels per row
+const int32_t ESTZEILEN=16;
+const int32_t ESTBLOECKE=4;
+// jobs are sampled at no more than ESTMAXLEN pixels a side
+const int32_t ESTMAXLEN=512;
+
+// process coordinator: default rows per range, restarts per worker
+// slot, a range running longer than PROZLANGSAM times the mean is
+// given to an idle worker as well
+const int32_t PROZZEILEN=16;
+const int32_t PROZNEUSTARTS=3;
+const double PROZLANGSAM=3.0;
+enum {
+	PBER_OFFEN=0,
+	PBER_VERGEBEN,
+	PBER_FERTIG
+};
+
+// tile walk: parameters the worker copies are loaded from
+const char TILEPAR[]="_walktile.par";
+// BMP file and info header
+const int32_t BMPKOPF=54;
+// volume: edge of the cubic chunks of the .ljv file, parameters the
+// slice workers copies are loaded from
+const int32_t VOLCHUNK=32;
+const char VOLPAR[]="_volume.par";
+
+// render daemon: job table size, open connections, states of a job
+const int32_t MAXDAEMONJOBS=1024;
+const int32_t MAXDAEMONCONN=64;
+enum {
+	DJOB_FREI=0,
+	DJOB_QUEUED,
+	DJOB_RUNNING,
+	DJOB_DONE,
+	DJOB_FAILED,
+	DJOB_CANCELLED
+};
+
+// result cache of calc: bump CACHEVERSION when exponents of equal
+// parameters change (kernels, trig approximations)
+const int32_t CACHEVERSION=1;
+const char CACHEMAGIC[]="LJC1";
+const char CACHEDIR[]="_ljapcache";
+// parts of the key besides function, sequence, x0, iter0 and tier
+const int32_t CACHEKEY_GEOMETRY=1;
+const int32_t CACHEKEY_ITER1=2;
+const char STATEMAGIC[]="LJS1";
+
+// timeline tracing: spans kept in a ring buffer, oldest overwritten
+const int32_t MAXTRACE=65536;
+
+// user defined f,g given as expression strings
+const int32_t MAXFORMULALEN=256;
+const int32_t MAXFORMULANODES=256;
+const int32_t MAXFORMULAREG=32;
+// BENCHFORMULA flags compiled formulas of the built-in functions slower
+// than that. Not a guarantee: the interpreter costs most on the cheap
+// function 1 and the sin-heavy 13, 14 and 18, which reach about 3
+const double FORMULAFACTOR=2.5;
+// BENCH compares every template at that size against the committed
+// exponents in BENCHREFDIR (regression check, written if missing)
+const int32_t BENCHREFLEN=64;
+const char BENCHREFDIR[]="benchref";
+
+enum {
+	FOP_CONST=1, FOP_X, FOP_R, FOP_B,
+	FOP_NEG, FOP_ADD, FOP_SUB, FOP_MUL, FOP_DIV, FOP_POW,
+	FOP_SIN, FOP_COS, FOP_TAN, FOP_ATAN, FOP_EXP, FOP_LOG, FOP_SQRT, FOP_ABS
+};
+
+
+// defines used in struct declarations
+
+// runs the statements with the constant TIER set to the sin/cos tier
+// of the calling thread. They have to end with return
+#define TIERWAHL(...) \
+	switch (trigtier) {\
+		case PRECISION_REFERENCE: { const int32_t TIER=PRECISION_REFERENCE; __VA_ARGS__; }\
+		case PRECISION_FLOAT: { const int32_t TIER=PRECISION_FLOAT; __VA_ARGS__; }\
+		case PRECISION_TABLE: { const int32_t TIER=PRECISION_TABLE; __VA_ARGS__; }\
+		default: { const int32_t TIER=PRECISION_DOUBLE; __VA_ARGS__; }\
+	}
+
+// lane loops calling the class's own evalT non-virtually, so
+// the compiler can inline and vectorize the function body
+#define EVALVECDECL \
+	virtual void evalvec(const int32_t,const double*,const double*,double*);\
+	virtual void evalvec(const int32_t,const double*,const double*,double*,double*);
+
+// the body of eval as template evalT<TIER>, eval itself picks the tier
+#define TIEREVALDECL \
+	template<int32_t TIER> inline void evalT(const double,const double,double&);\
+	template<int32_t TIER> inline void evalT(const double,const double,double&,double&);\
+	virtual void eval(const double,const double,double&);\
+	virtual void eval(const double,const double,double&,double&);
+
+#define TIEREVALDEF(KLASSE) \
+void KLASSE::eval(const double x,const double r,double& fx) {\
+	TIERWAHL(evalT<TIER>(x,r,fx); return)\
+}\
+void KLASSE::eval(const double x,const double r,double& fx,double& abl) {\
+	TIERWAHL(evalT<TIER>(x,r,fx,abl); return)\
+}
+
+// f is defined once as template fkt<TIER,T,R>, f'(x) follows from
+// evaluating it with dual numbers, the text of f' from evaluating it
+// with DualText
+#define DUALEVALDECL \
+	template<int32_t TIER,class T,class R> inline T fkt(const T&,const R&);\
+	TIEREVALDECL\
+	virtual void evalabl(const double,const double,double&);
+
+#define DUALEVALDEF(KLASSE) \
+template<int32_t TIER> inline void KLASSE::evalT(const double x,const double r,double& fx) {\
+	fx=fkt<TIER,double>(x,r);\
+}\
+template<int32_t TIER> inline void KLASSE::evalT(const double x,const double r,double& fx,double& abl) {\
+	const Dual e=fkt<TIER,Dual>(Dual(x,1.0),r);\
+	fx=e.v;\
+	abl=e.d;\
+}\
+TIEREVALDEF(KLASSE)\
+void KLASSE::evalabl(const double x,const double r,double& abl) {\
+	double fx;\
+	TIERWAHL(evalT<TIER>(x,r,fx,abl); return)\
+}\
+char* KLASSE::ablStr(char* s) {\
+	const DualText e=fkt<0,DualText>(DualText("x","1"),DualText("r","0"));\
+	sprintf(s,"N(%i) [=f'] %s",id,e.d.s);\
+	return s;\
+}
+
+#define EVALVECDEF(KLASSE) \
+void KLASSE::evalvec(const int32_t n,const double* x,const double* r,double* fx) {\
+	switch (isa) {\
+		case ISA_AVX512: laneseval512<KLASSE>(this,n,x,r,fx); return;\
+		case ISA_AVX2: lanesevalavx2<KLASSE>(this,n,x,r,fx); return;\
+	}\
+	lanesevalsse2<KLASSE>(this,n,x,r,fx);\
+}\
+void KLASSE::evalvec(const int32_t n,const double* x,const double* r,double* fx,double* abl) {\
+	switch (isa) {\
+		case ISA_AVX512: laneseval512<KLASSE>(this,n,x,r,fx,abl); return;\
+		case ISA_AVX2: lanesevalavx2<KLASSE>(this,n,x,r,fx,abl); return;\
+	}\
+	lanesevalsse2<KLASSE>(this,n,x,r,fx,abl);\
+}
+
+// kernels compiled once per instruction set: the attribute lets gcc/clang
+// generate AVX code in a binary built for the SSE2 baseline. flatten
+// inlines the function bodies, so they are compiled for the target too
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define ISADISPATCH
+	#define ISAAVX2 __attribute__((target("avx2,fma"),flatten))
+	#define ISAAVX512 __attribute__((target("avx512f,avx2,fma"),flatten))
+	#define ISASSE2 __attribute__((flatten))
+#else
+	#define ISAAVX2
+	#define ISAAVX512
+	#define ISASSE2
+#endif
+
+// a*b+c is not contracted to an FMA instruction, so every variant
+// computes the same exponents. Without FP traps both sides of a
+// selection may be computed, which lets the lane loops vectorize
+#if defined(__clang__)
+	#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+	#pragma GCC optimize("fp-contract=off","no-trapping-math")
+#endif
+
+// the tier is chosen once per block, not per sin/cos. Full blocks
+// have a lane count known at compile time
+#define ISALANES(NAME,ATTR) \
+template<class K> ATTR void NAME(K* p,const int32_t n,const double* x,const double* r,double* fx) {\
+	if (n==VECLEN) { TIERWAHL(for(int32_t i=0;i<VECLEN;i++) p->K::template evalT<TIER>(x[i],r[i],fx[i]); return) }\
+	TIERWAHL(for(int32_t i=0;i<n;i++) p->K::template evalT<TIER>(x[i],r[i],fx[i]); return)\
+}\
+template<class K> ATTR void NAME(K* p,const int32_t n,const double* x,const double* r,double* fx,double* abl) {\
+	if (n==VECLEN) { TIERWAHL(for(int32_t i=0;i<VECLEN;i++) p->K::template evalT<TIER>(x[i],r[i],fx[i],abl[i]); return) }\
+	TIERWAHL(for(int32_t i=0;i<n;i++) p->K::template evalT<TIER>(x[i],r[i],fx[i],abl[i]); return)\
+}
+
+#define ISAFORMULA(NAME,ATTR) \
+ATTR void NAME(const FormulaProgram& prog,const int32_t n,const double* x,const double* r,double* fx,double* gx) {\
+	if (n==VECLEN) { TIERWAHL(formularun<VECLEN,TIER>(prog,n,x,r,fx,gx); return) }\
+	TIERWAHL(formularun<0,TIER>(prog,n,x,r,fx,gx); return)\
+}
+
+// IntervalColoring::farbe inlined: a value in no interval (NaN)
+// keeps the color of the pixel before
+#define ISACOLOR(NAME,ATTR) \
+ATTR void NAME(IntervalColoring* farbe,const double* w,uint8_t* bgr,const int32_t anz) {\
+	int32_t r=0,g=0,b=0;\
+	const double mingl=farbe->mingl,maxgl=farbe->maxgl;\
+	const int32_t intanz=farbe->intanz;\
+	ColIntv* const* ints=farbe->ints;\
+	for(int32_t i=0;i<anz;i++) {\
+		const double v=w[i];\
+		if (v<mingl) { r=farbe->lr; g=farbe->lg; b=farbe->lb; }\
+		else if (v>maxgl) { r=farbe->rr; g=farbe->rg; b=farbe->rb; }\
+		else for(int32_t k=0;k<intanz;k++) {\
+			const ColIntv* c=ints[k];\
+			if ((v>=c->gl)&&(v<c->gr)) {\
+				const double wg=(v-c->gl)/c->breite;\
+				r=c->lr+int32_t(wg*c->dr);\
+				g=c->lg+int32_t(wg*c->dg);\
+				b=c->lb+int32_t(wg*c->db);\
+				break;\
+			}\
+		}\
+		bgr[0]=b;\
+		bgr[1]=g;\
+		bgr[2]=r;\
+		bgr+=3;\
+	}\
+}
+
 
 // struct definitions
 
+struct Dual {
+	// value and derivative with respect to x
+	double v,d;
+
+	Dual() { }
+	Dual(const double av,const double ad=0.0) { v=av; d=ad; }
+};
+
+struct DualTerm {
+	// text of an expression, p: 0 operand or function, 1 product, 2 sum
+	char s[400];
+	int32_t p;
+
+	DualTerm() { s[0]=0; p=0; }
+	DualTerm(const char* as,const int32_t ap=0) { s[0]=0; p=ap; add(as); }
+	void add(const char* a) {
+		// appends a, cut off at the buffer end
+		int32_t l=strlen(s);
+		while ( (*a) && (l<(int32_t)sizeof(s)-1) ) s[l++]=*a++;
+		s[l]=0;
+	}
+};
+
+struct DualText {
+	// value and derivative with respect to x as text, for ablStr
+	DualTerm v,d;
+
+	DualText() { }
+	DualText(const double c);
+	DualText(const char* av,const char* ad) : v(av),d(ad) { }
+	DualText(const DualTerm& av,const DualTerm& ad) : v(av),d(ad) { }
+};
+
 struct Bitmap {
 	int32_t xlen,ylen,bytes,ybytes;
 	uint8_t* bmp;
@@ -74,11 +443,21 @@ struct Function {
 	int32_t typ;
 	IterDouble* iterb;
 
+	virtual ~Function() { }
 	virtual void eval(const double,const double,double&) { };
 	virtual void eval(const double,const double,double&,double&) { };
 	virtual void evalabl(const double,const double,double&) { }
+	// evaluate n<=VECLEN lanes at once, default: one scalar eval per lane
+	virtual void evalvec(const int32_t n,const double* x,const double* r,double* fx) {
+		for(int32_t i=0;i<n;i++) eval(x[i],r[i],fx[i]);
+	}
+	virtual void evalvec(const int32_t n,const double* x,const double* r,double* fx,double* abl) {
+		for(int32_t i=0;i<n;i++) eval(x[i],r[i],fx[i],abl[i]);
+	}
 
 	virtual void save(FILE *) { };
+	// everything the exponents depend on, numbers exact (unlike save)
+	virtual void cachekey(FILE* f) { save(f); }
 	virtual int32_t load(const int32_t,FILE *) { return 0; };
 	virtual int32_t iterStart(void) { return 0; };
 	virtual int32_t iterWeiter(void) { return 0; }
@@ -92,15 +471,14 @@ struct FunctionI : public Function {
 	// f=r*x*(1-x)
 	// g=f'
 	FunctionI();
-	virtual void eval(const double,const double,double&);
-	virtual void eval(const double,const double,double&,double&);
-	virtual void evalabl(const double x,const double r,double& abl);
+	DUALEVALDECL
+	EVALVECDECL
 	virtual void save(FILE *);
 	virtual int32_t load(const int32_t,FILE *);
 	virtual int32_t iterStart(void) { return 1; }; // einmal geht
 	virtual int32_t iterWeitloer(void) { return 0; } // aber nicht weiter
 	virtual char* fktStr(char* s) { sprintf(s,"N(%i) r*x*(1-x)",id); return s; }
-	virtual char* ablStr(char* s) { sprintf(s,"N(%i) [=f'] r-2rx",id); return s; }
+	virtual char* ablStr(char* s);
 };
 
 struct FunctionII : public Function {
@@ -109,10 +487,10 @@ struct FunctionII : public Function {
 	double b,b2;
 
 	FunctionII();
-	virtual void eval(const double,const double,double&);
-	virtual void eval(const double,const double,double&,double&);
-	virtual void evalabl(const double x,const double r,double& abl);
+	DUALEVALDECL
+	EVALVECDECL
 	virtual void save(FILE *);
+	virtual void cachekey(FILE*);
 	virtual int32_t load(const int32_t aid,FILE *);
 	virtual void set_b(const double d) { b=d; b2=d+d; }
 	virtual int32_t iterStart(void);
@@ -126,9 +504,9 @@ struct FunctionVII : public FunctionII {
 	// g=r-2rx
 
 	FunctionVII();
-	virtual void eval(const double,const double,double&);
-	virtual void eval(const double,const double,double&,double&);
+	TIEREVALDECL
 	virtual void evalabl(const double,const double,double&);
+	EVALVECDECL
 	virtual void save(FILE *);
 	virtual char* fktStr(char* s);
 	virtual char* ablStr(char* s);
@@ -141,11 +519,18 @@ struct FunctionMetaABSC : public FunctionII {
 	double I0MIN,I1MIN;
 	double I0MAX,I1MAX;
 	Function *fint,*fext;
+	// recent blocks and those with lanes on both sides, shared by the
+	// worker threads without locking as they only steer a heuristic
+	std::atomic<int32_t> vecblocks,vecmixed;
 
 	FunctionMetaABSC();
 	virtual void eval(const double,const double,double&);
 	virtual void eval(const double,const double,double&,double&);
+	virtual void evalvec(const int32_t,const double*,const double*,double*);
+	virtual void evalvec(const int32_t,const double*,const double*,double*,double*);
+	void evalsectionvec(const int32_t,const double*,const double*,double*,double*,const double,const double);
 	virtual void save(FILE *);
+	virtual void cachekey(FILE*);
 	virtual char* fktStr(char* s);
 	void setfint(Function* p) { fint=p; }
 	void setfext(Function* p) { fext=p; }
@@ -161,9 +546,9 @@ struct FunctionX : public FunctionII {
 	// f=r*sin^2(x-r)+b*sin^2(x+2r)
 	// g=rx-b*fin^2(r*x-b)
 	FunctionX();
-	virtual void eval(const double,const double,double&);
-	virtual void eval(const double,const double,double&,double&);
+	TIEREVALDECL
 	virtual void evalabl(const double x,const double r,double& abl);
+	EVALVECDECL
 	virtual void save(FILE *);
 	virtual char* fktStr(char* s);
 	virtual char* ablStr(char* s);
@@ -178,7 +563,10 @@ struct FunctionMetaDet : public FunctionII {
 	FunctionMetaDet();
 	virtual void eval(const double,const double,double&);
 	virtual void eval(const double,const double,double&,double&);
+	virtual void evalvec(const int32_t,const double*,const double*,double*);
+	virtual void evalvec(const int32_t,const double*,const double*,double*,double*);
 	virtual void save(FILE *);
+	virtual void cachekey(FILE*);
 	virtual char* fktStr(char* s);
 	void setF(Function* p,const int32_t a) { f=p; fwas=a; }
 	void setAbl(Function* p,const int32_t a) { abl=p; ablwas=a; }
@@ -193,9 +581,9 @@ struct FunctionIX : public FunctionII {
 	// f=b*sin(x+r)+b*sin^2(b*x+r)
 	// g=sin^2(x+r*b)-r*x
 	FunctionIX();
-	virtual void eval(const double,const double,double&);
-	virtual void eval(const double,const double,double&,double&);
+	TIEREVALDECL
 	virtual void evalabl(const double x,const double r,double& abl);
+	EVALVECDECL
 	virtual void save(FILE *);
 	virtual char* fktStr(char* s);
 	virtual char* ablStr(char* s);
@@ -205,9 +593,8 @@ struct FunctionSICO : public FunctionII {
 	// f=b*sin(x+r*cos(x+r))
 	// g=f'
 	FunctionSICO();
-	virtual void eval(const double,const double,double&);
-	virtual void eval(const double,const double,double&,double&);
-	virtual void evalabl(const double,const double,double&);
+	DUALEVALDECL
+	EVALVECDECL
 	virtual void save(FILE *);
 	virtual int32_t load(const int32_t aid,FILE *);
 	virtual int32_t iterStart(void);
@@ -220,9 +607,8 @@ struct FunctionLSIN : public FunctionII {
 	// f=r*sin(x)*(1-b*sin(x+r))
 	// g=f'
 	FunctionLSIN();
-	virtual void eval(const double,const double,double&);
-	virtual void eval(const double,const double,double&,double&);
-	virtual void evalabl(const double x,const double r,double& abl);
+	DUALEVALDECL
+	EVALVECDECL
 	virtual void save(FILE *);
 	virtual char* fktStr(char* s);
 	virtual char* ablStr(char* s);
@@ -232,9 +618,8 @@ struct FunctionATAN : public FunctionII {
 	// f=b*atan((x+r)*sin(x+r))
 	// g=f'
 	FunctionATAN();
-	virtual void eval(const double,const double,double&);
-	virtual void eval(const double,const double,double&,double&);
-	virtual void evalabl(const double,const double,double&);
+	DUALEVALDECL
+	EVALVECDECL
 	virtual void save(FILE *);
 	virtual char* fktStr(char* s);
 	virtual char* ablStr(char* s);
@@ -243,10 +628,77 @@ struct FunctionATAN : public FunctionII {
 struct FunctionIII : public FunctionII {
 	// f=b*sin(x+r)*sin(x-r);
 	FunctionIII();
+	DUALEVALDECL
+	EVALVECDECL
+	virtual void save(FILE *);
+	virtual char* fktStr(char* s);
+	virtual char* ablStr(char* s);
+};
+
+struct FormulaNode {
+	int32_t op,a,b;
+	double wert;
+};
+
+struct FormulaInstr {
+	int32_t op,dst,a,b;
+	double wert;
+};
+
+// operand numbers: 0..MAXFORMULAREG-1 working registers, then
+// the inputs x and r and the broadcast constants (b included)
+const int32_t FORMULAREGX=MAXFORMULAREG;
+const int32_t FORMULAREGR=MAXFORMULAREG+1;
+const int32_t FORMULAREGBANK=MAXFORMULAREG+2;
+
+struct FormulaProgram {
+	// register based bytecode, every instruction works on VECLEN lanes
+	FormulaInstr instr[MAXFORMULANODES];
+	int32_t anzinstr,anzreg;
+	int32_t regf,regg; // output operands, -1 if not computed
+	double bank[MAXFORMULAREG][VECLEN];
+	int32_t anzbank,bankb;
+
+	FormulaProgram() { anzinstr=anzreg=anzbank=0; regf=regg=bankb=-1; }
+	void set_b(const double);
+	void run(const int32_t,const double*,const double*,double*,double*);
+};
+
+struct FormulaCompiler {
+	// parses f and g into one node table with constant folding and
+	// common subexpressions shared, then emits the reachable nodes
+	FormulaNode nodes[MAXFORMULANODES];
+	int32_t anznodes;
+	const char* pos;
+	int32_t fehler;
+
+	int32_t compile(const char*,const char*,FormulaProgram&);
+	int32_t node(const int32_t,const int32_t,const int32_t,const double);
+	int32_t powint(const int32_t,const int32_t);
+	int32_t parseExpr(void);
+	int32_t parseTerm(void);
+	int32_t parseUnary(void);
+	int32_t parsePower(void);
+	int32_t parsePrimary(void);
+	int32_t parseAll(const char*);
+	void skipSpace(void) { while ((*pos==' ')||(*pos=='\t')) pos++; }
+};
+
+struct FunctionFormula : public FunctionII {
+	// f and g given as expressions in x, r and b
+	char fstr[MAXFORMULALEN],gstr[MAXFORMULALEN];
+	FormulaProgram progf,progfg;
+
+	FunctionFormula();
+	int32_t setformula(const char*,const char*);
+	virtual void set_b(const double);
 	virtual void eval(const double,const double,double&);
 	virtual void eval(const double,const double,double&,double&);
-	virtual void evalabl(const double x,const double r,double& abl);
+	virtual void evalabl(const double,const double,double&);
+	virtual void evalvec(const int32_t,const double*,const double*,double*);
+	virtual void evalvec(const int32_t,const double*,const double*,double*,double*);
 	virtual void save(FILE *);
+	virtual int32_t load(const int32_t,FILE *);
 	virtual char* fktStr(char* s);
 	virtual char* ablStr(char* s);
 };
@@ -294,6 +746,145 @@ struct Point32_t {
 	double x,y;
 };
 
+struct PerfCounters {
+	// one counter group of the calling thread (Linux perf_event_open)
+	int32_t fd[ANZPERF]; // -1: not available
+	int32_t gruppe[ANZPERF]; // position in the group read
+	int32_t anz;
+
+	PerfCounters() { anz=0; for(int32_t i=0;i<ANZPERF;i++) fd[i]=gruppe[i]=-1; }
+	~PerfCounters() { close(); }
+	int32_t open(const uint64_t);
+	void close(void);
+	int32_t read(uint64_t*);
+};
+
+struct CalcStats {
+	// counters of one worker thread in the last calc
+	int64_t pixels,evals,logs,skipped,nanorbits;
+	int64_t ns[ANZPHASES]; // wall time
+	int64_t cpuns; // cpu time of the thread
+	uint64_t perf[ANZPHASES][ANZPERF]; // profiling mode only
+
+	CalcStats() { clear(); }
+	void clear(void);
+	void add(const CalcStats&);
+};
+
+struct CalcJob {
+	// rows [start..ende] shared by the worker threads of one calc
+	int32_t start,ende;
+	Point32_t vx,vy;
+	std::atomic<int32_t> nextrow,rowsdone;
+	time_t t0;
+	// pixels already known (viewport), NULL: compute all
+	const uint8_t* bekannt;
+	// continue every pixel from the recorded state, record it
+	int32_t fortsetzen,aufzeichnen;
+	// sample of ESTIMATE: progress, zeilefertig and sketches untouched
+	int32_t probe;
+};
+
+struct LambdaSketch {
+	// mergeable histogram of the exponents with bounded relative error
+	// of the quantiles, filled by the worker threads while they compute
+	int64_t neg[SKETCHBINS],pos[SKETCHBINS];
+	int64_t null,nan,anz;
+	double minw,maxw;
+
+	LambdaSketch() { clear(); }
+	void clear(void);
+	void add(const double);
+	void merge(const LambdaSketch&);
+	double quantil(const double) const;
+};
+
+struct PyramidEbene {
+	// one level while PYRAMID streams: the rows of the current tile row
+	// and a row waiting for its partner to be halved into the level above
+	int64_t breite,hoehe;
+	int32_t zeilen,gesamt,tilereihe,halbda;
+	uint8_t *puffer,*halb;
+};
+
+struct TileEintrag {
+	// one encoded tile of the server cache (malloc), zeit: last use
+	int32_t z,x,y,len;
+	uint8_t* daten;
+	int64_t zeit;
+};
+
+struct SampleJob {
+	// sub-pixel samples at (A[i]|B[i]) of one supersampling pass,
+	// taken VECLEN at a time by the worker threads
+	double *A,*B,*erg;
+	int32_t anz;
+	std::atomic<int32_t> next;
+};
+
+struct BatchJob {
+	// one line of a batch manifest and its outcome
+	char par[1024],out[1024],ovr[MAXBATCHLINE];
+	int32_t nr,runner,ok;
+	char fehler[256];
+	int32_t threads; // calculation threads the job got
+	int64_t mem; // bytes reserved by admission control
+	int64_t nswait,nsload,nscalc,nssave;
+	double schaetzung; // estimated calc seconds, -1: none
+};
+
+struct BatchQueue {
+	// jobs are taken in manifest order, each waits until its memory fits
+	BatchJob* jobs;
+	int32_t anz;
+	std::atomic<int32_t> next;
+	std::mutex m;
+	std::condition_variable cv;
+	int64_t memfrei,memlimit;
+	// calculation threads not used by running jobs
+	int32_t threadsfrei;
+};
+
+struct SuchKandidat {
+	// one point of the search space and its thumbnail score.
+	// fid, ablid: functions of METADET, sec: bounds of METAABSC
+	int32_t gen,nr;
+	double b;
+	char seq[MAXSUCHSEQ+1];
+	double sec[4];
+	int32_t fid,ablid;
+	double score;
+};
+
+struct ProzBereich {
+	// rows [a..b] of a coordinated RUN
+	int32_t a,b,zustand;
+	int64_t tstart;
+};
+
+struct ProzWorker {
+	// bereich: range being computed, -1: idle
+	int32_t pid,fd,bereich,neustarts;
+	int64_t tstart;
+};
+
+struct TraceEvent {
+	const char* name;
+	int32_t tid,arg; // arg: frame or row number, -1 if none
+	int64_t ts,dur;
+};
+
+struct TraceSpan {
+	// records one complete event from construction to end of scope,
+	// does nothing when tracing is off
+	const char* name;
+	int32_t arg;
+	int64_t ts;
+
+	inline TraceSpan(const char*,const int32_t=-1);
+	inline ~TraceSpan();
+};
+
 struct Ljapunow {
 	Function *fkt;
 	IntervalColoring *farbe;
@@ -304,13 +895,109 @@ struct Ljapunow {
     char sequence[256];
     double* exps;
     double x0;
+    // r of the symbol C, constant over the image
+    double cwert;
     Point32_t upperleft,lowerleft,lowerright;
 	IterDouble* iterC; 
+	int32_t threads;
+	// nanoseconds per phase of the last calc (summed over threads), coloring and saving
+	int64_t phasens[ANZPHASES];
+	int64_t calcns;
+	CalcStats threadstats[MAXTHREADS];
+	int32_t statthreads;
+	// nanoseconds per pixel of the last calc, NULL if not recorded
+	float* kosten;
+	// profiling with hardware counters, perffpraw: raw event code of FP operations
+	int32_t profiling;
+	std::atomic<int32_t> perfok; // set by the worker threads
+	uint64_t perffpraw;
+	uint64_t perfcoloring[ANZPERF];
+	int32_t precision;
+	// no progress output (batch jobs)
+	int32_t quiet;
+	// set from another thread to stop calc after the current rows
+	std::atomic<int32_t> abbruch;
+	// viewport mode: grid and exponents of the last whole image,
+	// vpkey: everything but the geometry
+	int32_t viewport;
+	double* vpexps;
+	int32_t vplenx,vpleny;
+	Point32_t vpll,vpvx,vpvy;
+	char* vpkey;
+	// state mode: orbit point and lambda sum of every pixel after
+	// zschritte double steps of the computing phase, all pixels share
+	// step count and sequence position. zkey: everything but iter1
+	int32_t zustand,zschritte,zseqpos;
+	double *zpx,*zlambda;
+	char* zkey;
+	// warm start mode: transient of iter0h/warmdiv after the first
+	// block of a tile, 0: off
+	int32_t warmdiv;
+	// walk gating: candidates whose thumbnail scores below gateschwelle
+	// are not computed in full, gatediv 0: off
+	int32_t gatediv;
+	double gateschwelle;
+	int32_t gateanz,gatepromoted;
+	int64_t gatethumbevals,gatefullevals,gatethumbns,gatefullns;
+	// progress of the running calc for STATUS and partial saves:
+	// zeilefertig[y] is set once row y is in exps, fortschritt of
+	// fortschrittanz rows (tiles in warm start mode) are done
+	// (release store after the row, savepartial loads with acquire)
+	std::atomic<uint8_t>* zeilefertig;
+	int32_t zeilefertiglen;
+	std::atomic<int32_t> fortschritt,fortschrittanz;
+	// supersampling: pixels whose neighbours differ by more than aalambda
+	// in the exponent or aafarbe in a color channel get aasamples-1
+	// extra samples aaexps[aaidx[i]..], aaidx -1: none. 0,1: off
+	int32_t aasamples,aafarbe;
+	double aalambda;
+	int32_t *aaidx;
+	double* aaexps;
+	int32_t aaanz,aalen;
+	int64_t aans;
+	// exponents of the last whole image, collected while computing.
+	// skizzen: one per worker thread during calc, skizzeok 0: stale
+	LambdaSketch skizze;
+	LambdaSketch* skizzen;
+	int32_t skizzeok;
 
     Ljapunow();
     virtual ~Ljapunow();
 
     int32_t calc(const int32_t start,const int32_t ende);
+	void calcRows(CalcJob*,const int32_t);
+	void calcTiles(CalcJob*,const int32_t);
+	void zeilenstart(const int32_t,const int32_t,const int32_t);
+	void supersample(const Point32_t&,const Point32_t&);
+	void calcSamples(SampleJob*,const int32_t);
+	void setsupersample(const int32_t,const double,const int32_t);
+	void aafrei(void);
+	int32_t autocolor(const int32_t);
+	void zeilenende(const int32_t,const int32_t);
+	void checkwarm(void);
+	void setgate(const double,const int32_t);
+	double gatescore(double&,double&,double&);
+	int32_t walkcalc(void);
+	void gatestart(void);
+	void gatereport(void);
+	void setthreads(const int32_t);
+	void setheatmap(const int32_t);
+	void printstats(FILE*);
+	void savestatsjson(const char*);
+	void saveheatmap(const char*);
+	void printprofile(FILE*);
+	void setprecision(const int32_t);
+	void checkprecision(void);
+	char* cachekey(int32_t&,const int32_t=CACHEKEY_GEOMETRY|CACHEKEY_ITER1);
+	int32_t viewportreuse(const char*,const Point32_t&,const Point32_t&,uint8_t*,const int32_t=1,int32_t* =NULL);
+	double estimate(int64_t&,int64_t&,const int32_t);
+	void viewportstore(char*,const Point32_t&,const Point32_t&);
+	void setviewport(const int32_t);
+	void setzustand(const int32_t);
+	int32_t savestate(const char*);
+	int32_t loadstate(const char*);
+	int32_t cacheload(void);
+	void cachestore(void);
 	int32_t iterStart(void);
 	int32_t iterWeiter(void);
 
@@ -320,24 +1007,119 @@ struct Ljapunow {
 	char* getSequence(char* s);
     void createBmp(Bitmap*);
     void setfarbe(IntervalColoring*);
-    void setFunction(Function *f) { fkt=f; }
+    void setFunction(Function *f) { if ((fkt)&&(fkt!=f)) delete fkt; fkt=f; }
     void setSequence(char *s);
+	int32_t mitC(void);
     void setPosition(const double,const double,const double,const double,const double,const double);
     void setlen(const int32_t xl,const int32_t yl);
     void setiter(const int32_t i0,const int32_t i1);
     // saving values
 	void savepar(char *fn);
+	void savepar(FILE*);
     void saveexp(char *fn);
     void savebmp(char *fn,Bitmap*);
 	void savedescr(const char* fn);
+	void savepartial(const char*);
 	// rect manipulations
 	void crop(const int32_t,const int32_t,const int32_t,const int32_t);
-	void tile(char*,const int32_t,const int32_t);
+	void tile(char*,const int32_t,const int32_t,const int32_t=1);
+	int32_t pyramid(const char*,const int32_t,const int32_t=1);
+	int32_t volume(const char*,const int32_t,const double,const double,const int32_t=1);
 	void centerPixel(const int32_t,const int32_t);
 	void rot(const int32_t);
 	void stretch(const double,const double);
 };
 
+struct SuchArbeit {
+	// candidates of one generation, taken one at a time by the workers
+	Ljapunow** lj;
+	SuchKandidat* k;
+	int32_t anz;
+	std::atomic<int32_t> next;
+};
+
+struct TileArbeit {
+	// tiles of one WALKTILE, taken one at a time by the workers, whose
+	// rows are written into the mosaic files under m
+	int32_t anzx,anzy,einzeln;
+	const char* prefix;
+	Point32_t ll,vx,vy;
+	int64_t breite; // mosaic width in pixels
+	FILE *fljd,*fbmp;
+	std::mutex m;
+	std::atomic<int32_t> next,fertig;
+	std::atomic<int32_t>* abbruch; // of the Ljapunow tiled
+};
+
+struct VolumeArbeit {
+	// slices of one VOLUME, taken one at a time by the workers, which
+	// write them into the chunks under m. xy, xz, yz: previews or NULL
+	int32_t anz,nbx,nby;
+	double c0,dc;
+	FILE* f;
+	double *xy,*xz,*yz;
+	std::mutex m;
+	std::atomic<int32_t> next,fertig;
+	std::atomic<int32_t>* abbruch; // of the Ljapunow sliced
+};
+
+struct TileServer {
+	// pyramid served over HTTP: tiles on disk, others computed by lj
+	// from the pyramid parameters and kept in the cache, oldest out first
+	char dir[1024];
+	// POST /quit/schluessel stops the server
+	char schluessel[20];
+	int32_t lenx,leny,T,Z;
+	Point32_t ul,vx,vy;
+	Ljapunow* lj;
+	TileEintrag* cache;
+	int32_t anzcache,maxcache;
+	int64_t uhr,treffer,gelesen,berechnet;
+};
+
+struct DaemonJob {
+	// out "-": exponents are kept for FETCH instead of written to disk
+	char par[1024],out[1024],ovr[MAXBATCHLINE];
+	int32_t id,prio,zustand;
+	char fehler[256];
+	int32_t warten; // connections in WAIT, slot is not reused meanwhile
+	Ljapunow* lj; // while running, for CANCEL
+	double schaetzung; // estimated calc seconds, -1: none
+	double* erg;
+	int32_t ergx,ergy;
+	int64_t nscalc;
+};
+
+struct Daemon {
+	// runners keep their Ljapunow and bitmap between jobs.
+	// ids count up, slots of finished jobs are reused
+	DaemonJob* jobs;
+	int32_t anz,ende,lfd,letzteid;
+	// shortest estimated job first within a priority
+	int32_t ordnung;
+	std::mutex m;
+	std::condition_variable cv;
+	// connection threads, joined once verbfd is -1 and at shutdown
+	std::thread* verb[MAXDAEMONCONN];
+	int32_t verbfd[MAXDAEMONCONN];
+
+	DaemonJob* naechster(void);
+	DaemonJob* suche(const int32_t);
+	DaemonJob* neu(void);
+};
+
+struct MenuJob {
+	// RUN or walk command running in the background (ASYNC mode),
+	// th is joined by the menu once laeuft dropped to 0
+	char tmp[1000],utmp[1000];
+	std::thread* th;
+	std::atomic<int32_t> laeuft;
+	int64_t t0;
+	// held by LOADCOLOR and SAVE in the menu, by the final saves of RUN
+	// and while supersample colors the image
+	std::mutex m;
+};
+
 
 // forward declarations
 
@@ -346,11 +1128,14 @@ Function* getNewFunction(const int32_t);
 IntervalColoring* loadfaerbung(FILE*);
 inline double fastsin(double);
 inline double fastcos(double);
+inline double formulaop(const int32_t,const double,const double);
 
 char dez(const char c);
 char* stripext(char*);
 char* upper(char*);
 void writehex(FILE*,const char*);
+void writejson(FILE*,const char*);
+void bmpKopf(FILE*,const int32_t,const int32_t);
 inline double maximumD(const double,const double);
 inline int32_t maximumI(const int32_t,const int32_t);
 char* chomp(char *);
@@ -358,6 +1143,25 @@ char* upper(char*);
 char* removeStr(const char*,const char*,char*);
 int32_t getFirstColorFile(char*);
 int32_t getNextColorFile(char*);
+void benchFormula(Ljapunow*);
+void benchTemplates(const int32_t,const int32_t,const char*);
+inline int64_t nanosec(void);
+inline int64_t cpunanosec(void);
+int32_t fseek64(FILE*,const int64_t);
+void setTrace(const int32_t);
+int32_t saveTrace(const char*);
+int32_t detectIsa(void);
+int32_t setIsa(const int32_t);
+int32_t runBatch(const char*,const int32_t,const int32_t,const char*,const int32_t=0);
+double estimateJob(const char*,char*);
+void runSearch(Ljapunow*,const int32_t,const int32_t,const int32_t,const char*);
+int32_t runDaemon(const char*,const int32_t,const int32_t=0);
+uint64_t fnv1a(const void*,const int64_t,uint64_t);
+void cacheEvict(void);
+void setCache(const int32_t,const char*);
+int32_t runClient(const char*);
+int32_t runProc(Ljapunow*,const int32_t,const int32_t);
+int32_t runTileServer(const char*,const int32_t,const int32_t);
 
 
 // defines as small functions
@@ -371,6 +1175,60 @@ int32_t getNextColorFile(char*);
 
 Ljapunow* ljap=NULL;
 FILE *ffarbe=NULL;
+// file numbers of the walks, continued over the session
+int32_t iterfilecount=1;
+int32_t tilefilenr=1;
+// ASYNC(1): RUN and walks run as background jobs
+int32_t async=0;
+MenuJob menujob;
+// instruction set of the kernels in use and the best one the cpu supports
+int32_t isa=ISA_SSE2;
+int32_t isadetected=ISA_SSE2;
+const char* ISANAMES[ANZISA]={ "sse2","avx2","avx512" };
+// result cache of calc, off if cachemax is 0
+char cachedir[1024];
+int64_t cachemax=0;
+std::atomic<int64_t> cachehits(0),cachemisses(0),cachedefekt(0);
+// precision tier of sin/cos, set per worker thread while calc runs
+thread_local int32_t trigtier=PRECISION_DOUBLE;
+const char* PRECISIONNAMES[ANZPRECISION]={ "reference","double","float-poly","table" };
+double sintab[SINTABLEN+1];
+std::once_flag sintabonce;
+// timeline: tracing on/off, events since TRACE(1), thread id (0: main,
+// every worker thread a new one from tracetidnext, so the workers of
+// concurrent jobs get tracks of their own)
+int32_t tracing=0;
+TraceEvent* traceevents=NULL;
+std::atomic<int64_t> traceanz(0);
+int64_t tracet0=0;
+thread_local int32_t tracetid=0;
+std::atomic<int32_t> tracetidnext(1);
+
+// built-in functions written as formulas, used by BENCHFORMULA
+struct BuiltinFormula {
+	int32_t id;
+	const char *f,*g;
+};
+
+const BuiltinFormula BUILTINFORMULAS[]={
+	{ ID_FKT_I, "r*x*(1-x)", "r-2*r*x" },
+	{ ID_FKT_II, "b*sin(x+r)^2", "2*b*sin(x+r)*cos(x+r)" },
+	{ ID_FKT_SICO, "b*sin(x+r*cos(x+r))", "b*(1-r*sin(x+r))*cos(x+r*cos(x+r))" },
+	{ ID_FKT_III, "b*sin(x+r)*sin(x-r)", "b*sin(2*x)" },
+	{ ID_FKT_VII, "b*sin(x+r)^2", "r-2*r*x" },
+	{ ID_FKT_IX, "b*sin(x+r)+b*sin(b*x+r)^2", "sin(x+r*b)^2-r*x" },
+	{ ID_FKT_X, "r*sin(x-r)^2+b*sin(x+2*r)^3", "r*x-b*sin(r*x-b)^4" },
+	{ ID_FKT_LSIN, "r*sin(x)*(1-b*sin(x+r))", "-r*(b*sin(2*x+r)-cos(x))" },
+	{ ID_FKT_ATAN, "b*atan((x+r)*sin(x+r))", "b*(sin(x+r)+(x+r)*cos(x+r))/(1+((x+r)*sin(x+r))^2)" },
+	{ 0, NULL, NULL }
+};
+
+// parameter files used by BENCH
+const char* BENCHTEMPLATES[]={
+	"01template","02template","03template","07template","11template","13template",
+	"14template","16template","17template","18template","22template","30template",
+	NULL
+};
 
 
 // function definitions
@@ -402,6 +1260,7 @@ Function* getNewFunction(const int32_t aid) {
         case ID_FKT_ATAN: p=new FunctionATAN(); break;
         case ID_FKT_METADET: p=new FunctionMetaDet(); break;
         case ID_FKT_METAABSC: p=new FunctionMetaABSC(); break;
+        case ID_FKT_FORMULA: p=new FunctionFormula(); break;
         default: printf("unknown function\n",aid); p=NULL; break;
     }
     return p;
@@ -427,6 +1286,7 @@ Function* loadFunction(FILE *f) {
 int32_t getFirstColorFile(char* ff) {
 	// construct a list of color file names
 	// in subdirectory COLORCOLLECTIONDIR
+	TraceSpan span("colorscan");
 	if (ffarbe) fclose(ffarbe);
 	char tmp[1024];
 	sprintf(tmp,"dir %s*.par /x /b >_ljap.tmp.farbe 2>nul",COLORCOLLECTIONDIR);
@@ -495,223 +1355,684 @@ char* upper(char* s) {
 
 // fastsin, fastcos von github: fasttrig.as
 
-inline double fastsin(double x) {
-	/*
-		based on:
-		Fast Polynomial Approximations to Sine and Cosine
-		Charles K Garrett, 2012
-	*/ 
-	
-	// range -pi..pi
-	if (x < -3.14159265) {
-		double d=(3.14159265-x) / 6.28318531;
-		x += floor(d)*6.28318531;
-	} else if (x > 3.14159265) {
-		double d=(x+3.14159265) / 6.28318531;
-		x -= floor(d)*6.28318531;
-	}
-	
+inline double fastsinpoly(const double x) {
+	// x in -pi..pi
 	double x2 = x * x;
 	return
 	(((((-2.05342856289746600727e-08*x2+2.70405218307799040084e-06)*x2
 	-1.98125763417806681909e-04)*x2+8.33255814755188010464e-03)*x2
 	-1.66665772196961623983e-01)*x2+9.99999707044156546685e-01)*x;
-
 }
 
-inline double fastcos(double x) {
-	return fastsin(x+PI05);
+inline double fastsinrange(const double x) {
+	// range -pi..pi. Both reductions are computed and one is selected,
+	// so lane loops can be vectorized
+	const double lo=x+floor((3.14159265-x) / 6.28318531)*6.28318531;
+	const double hi=x-floor((x+3.14159265) / 6.28318531)*6.28318531;
+
+	return (x < -3.14159265) ? lo : ((x > 3.14159265) ? hi : x);
 }
 
-char* removeStr(const char* q,const char* was,char* erg) {
-	char* p=strstr(q,was);
-	if (p) {
-		for(int32_t i=0;i<(p-q);i++) erg[i]=q[i];
-		strcpy(&erg[p-q],p+strlen(was));
-	} else {
-		strcpy(erg,q);
+inline float fastsinpolyf(const float x) {
+	float x2 = x * x;
+	return
+	(((((-2.05342856289746600727e-08f*x2+2.70405218307799040084e-06f)*x2
+	-1.98125763417806681909e-04f)*x2+8.33255814755188010464e-03f)*x2
+	-1.66665772196961623983e-01f)*x2+9.99999707044156546685e-01f)*x;
+}
+
+inline float fastsinrangef(float x) {
+	if (x < -3.14159265f) {
+		float d=(3.14159265f-x) / 6.28318531f;
+		x += floorf(d)*6.28318531f;
+	} else if (x > 3.14159265f) {
+		float d=(x+3.14159265f) / 6.28318531f;
+		x -= floorf(d)*6.28318531f;
 	}
 
-	return erg;
+	return x;
 }
 
-inline double maximumD(const double a,const double b) {
-	if (a > b) return a;
+void fillSinTable(void) {
+	for(int32_t i=0;i<=SINTABLEN;i++) sintab[i]=sin(i*(2.0*M_PI/SINTABLEN));
+}
 
-	return b;
+void initSinTable(void) {
+	// jobs may start calc concurrently
+	std::call_once(sintabonce,fillSinTable);
 }
 
-inline int32_t minimumI(const int32_t a,const int32_t b) {
-	if (a < b) return a;
-	return b;
+inline double tabsin(const double x) {
+	// linear interpolation, periodic by masking the index
+	const double t=x*(SINTABLEN/(2.0*M_PI));
+	if (!(fabs(t) < 1E15)) return sin(x);
+	const double fl=floor(t);
+	const int32_t i=(int32_t)((int64_t)fl & (SINTABLEN-1));
+	return sintab[i]+(t-fl)*(sintab[i+1]-sintab[i]);
 }
 
-char* chomp(char* s) {
-	if (!s) return 0;
-	for(int32_t i=strlen(s);i>=0;i--) if (s[i]<32) s[i]=0; else break;
-	return s;
+template<int32_t TIER> inline double tiersin(const double x) {
+	/*
+		based on:
+		Fast Polynomial Approximations to Sine and Cosine
+		Charles K Garrett, 2012
+	*/ 
+	// TIER is a constant, only one branch remains in the kernels
+	if (TIER==PRECISION_REFERENCE) return sin(x);
+	if (TIER==PRECISION_FLOAT) return fastsinpolyf(fastsinrangef((float)x));
+	if (TIER==PRECISION_TABLE) return tabsin(x);
+	
+	return fastsinpoly(fastsinrange(x));
 }
 
+template<int32_t TIER> inline double tiercos(const double x) {
+	if (TIER==PRECISION_REFERENCE) return cos(x);
+	return tiersin<TIER>(x+PI05);
+}
 
-// struct IterDouble
+template<int32_t TIER> inline void tiersincos(const double x,double& si,double& co) {
+	if (TIER==PRECISION_REFERENCE) {
+		si=sin(x);
+		co=cos(x);
+		return;
+	}
+	if (TIER==PRECISION_FLOAT) {
+		const float xr=fastsinrangef((float)x);
+		float xc=xr+(float)PI05;
+		if (xc > 3.14159265f) xc -= 6.28318531f;
+		si=fastsinpolyf(xr);
+		co=fastsinpolyf(xc);
+		return;
+	}
+	if (TIER==PRECISION_TABLE) {
+		si=tabsin(x);
+		co=tabsin(x+PI05);
+		return;
+	}
+	// one range reduction for both
+	const double xr=fastsinrange(x);
+	si=fastsinpoly(xr);
+	const double xc=xr+PI05;
+	co=fastsinpoly((xc > 3.14159265) ? xc-6.28318531 : xc);
+}
 
-IterDouble::IterDouble(const double a,const double b,const int32_t an) {
-	l=a; r=b;
-	anz=an;
-	if (an==1) delta=b-a; else delta=(b-a)/(an-1);
-	wert=l;
-	nr=0;
+// tier of the calling thread, outside the lane kernels
+inline double fastsin(double x) {
+	TIERWAHL(return tiersin<TIER>(x))
 }
 
-int32_t IterDouble::iterStart(void) {
-	wert=l;
-	nr=1;
-	return 1;
+inline double fastcos(double x) {
+	TIERWAHL(return tiercos<TIER>(x))
 }
 
-int32_t IterDouble::iterWeiter(void) {
-	wert+=delta;
-	nr++;
-	if (nr>anz) return 0;
-	return 1;
+inline void fastsincos(const double x,double& si,double& co) {
+	TIERWAHL(tiersincos<TIER>(x,si,co); return)
 }
 
 
-// Function LSIN
+// dual numbers and the elementary functions used in fkt<T>
 
-char* FunctionLSIN::fktStr(char* s) {
-	sprintf(s,"N(%i) r*sin(x)*(1-%le*sin(x+r))",id,b);
-	return s;
+inline Dual operator+(const Dual& a,const Dual& b) { return Dual(a.v+b.v,a.d+b.d); }
+inline Dual operator+(const Dual& a,const double b) { return Dual(a.v+b,a.d); }
+inline Dual operator+(const double a,const Dual& b) { return Dual(a+b.v,b.d); }
+inline Dual operator-(const Dual& a) { return Dual(-a.v,-a.d); }
+inline Dual operator-(const Dual& a,const Dual& b) { return Dual(a.v-b.v,a.d-b.d); }
+inline Dual operator-(const Dual& a,const double b) { return Dual(a.v-b,a.d); }
+inline Dual operator-(const double a,const Dual& b) { return Dual(a-b.v,-b.d); }
+inline Dual operator*(const Dual& a,const Dual& b) { return Dual(a.v*b.v,a.d*b.v+a.v*b.d); }
+inline Dual operator*(const Dual& a,const double b) { return Dual(a.v*b,a.d*b); }
+inline Dual operator*(const double a,const Dual& b) { return Dual(a*b.v,a*b.d); }
+inline Dual operator/(const Dual& a,const Dual& b) {
+	const double inv=1.0/b.v;
+	return Dual(a.v*inv,(a.d-a.v*inv*b.d)*inv);
 }
 
-char* FunctionLSIN::ablStr(char* s) {
-	sprintf(s,"N(%i) [==f'(x)] -r*(%le*sin(2x+r)-cos(x))",id,b);
-	return s;
+template<int32_t TIER> inline double fktsin(const double x) { return tiersin<TIER>(x); }
+template<int32_t TIER> inline double fktcos(const double x) { return tiercos<TIER>(x); }
+inline double fktatan(const double x) { return atan(x); }
+
+template<int32_t TIER> inline Dual fktsin(const Dual& x) {
+	// sine and cosine of the same argument computed together
+	double si,co;
+	tiersincos<TIER>(x.v,si,co);
+	return Dual(si,co*x.d);
 }
 
-FunctionLSIN::FunctionLSIN() {
-	id = ID_FKT_LSIN;
-	b=2.7;
-	typ=FKTTYP_NORMAL;
+template<int32_t TIER> inline Dual fktcos(const Dual& x) {
+	double si,co;
+	tiersincos<TIER>(x.v,si,co);
+	return Dual(co,-si*x.d);
 }
 
-void FunctionLSIN::eval(const double x,const double r,double& fx) {
-	fx=r*fastsin(x)*(1-b*fastsin(x+r));
+inline Dual fktatan(const Dual& x) {
+	return Dual(atan(x.v),x.d/(1.0+x.v*x.v));
 }
 
-void FunctionLSIN::save(FILE *f) {
-	char tmp[1024];
-	fprintf(f,"ID\n%i\n#FUNCTION LSIN\nB\n%le\n",id,b);
+// the same rules on text: 0 and 1 factors and 0 terms are left out,
+// subterms get parentheses only where the operator binds tighter
+
+int32_t dtNull(const DualTerm& a) { return strcmp(a.s,"0")==0; }
+int32_t dtEins(const DualTerm& a) { return strcmp(a.s,"1")==0; }
+
+DualTerm dtVerbinde(const DualTerm& a,const int32_t pa,const char* op,const DualTerm& b,const int32_t pb,const int32_t p) {
+	// a op b, operands with a precedence above pa/pb in parentheses
+	DualTerm e("",p);
+	if (a.p>pa) e.add("(");
+	e.add(a.s);
+	if (a.p>pa) e.add(")");
+	e.add(op);
+	if (b.p>pb) e.add("(");
+	e.add(b.s);
+	if (b.p>pb) e.add(")");
+	return e;
 }
 
-void FunctionLSIN::eval(const double x,const double r,double& fx,double& abl) {
-	fx=r*fastsin(x)*(1-b*fastsin(x+r));
-	abl=-r*(b*fastsin(x+x+r)-fastcos(x));
+DualTerm dtFkt(const char* name,const DualTerm& a) {
+	DualTerm e(name);
+	e.add("(");
+	e.add(a.s);
+	e.add(")");
+	return e;
 }
 
-void FunctionLSIN::evalabl(const double x,const double r,double& abl) {
-    abl=-r*(b*fastsin(x+x+r)-fastcos(x));
+DualTerm dtNeg(const DualTerm& a) {
+	if (dtNull(a)) return a;
+	return dtVerbinde(DualTerm(""),0,"-",a,1,2);
 }
 
+DualTerm dtAdd(const DualTerm& a,const DualTerm& b) {
+	if (dtNull(a)) return b;
+	if (dtNull(b)) return a;
+	return dtVerbinde(a,2,(b.s[0]=='-') ? "" : "+",b,2,2);
+}
 
-// Function ATAN
+DualTerm dtSub(const DualTerm& a,const DualTerm& b) {
+	if (dtNull(b)) return a;
+	if (dtNull(a)) return dtNeg(b);
+	return dtVerbinde(a,2,"-",b,1,2);
+}
 
-char* FunctionATAN::fktStr(char* s) {
-	sprintf(s,"N(%i) %le*atan((x+r)*sin(x+r))",id,b);
-	return s;
+DualTerm dtMul(const DualTerm& a,const DualTerm& b) {
+	if ((dtNull(a))||(dtNull(b))) return DualTerm("0");
+	if (dtEins(a)) return b;
+	if (dtEins(b)) return a;
+	if (strcmp(a.s,"-1")==0) return dtNeg(b);
+	if (strcmp(b.s,"-1")==0) return dtNeg(a);
+	return dtVerbinde(a,1,"*",b,1,1);
 }
 
-char* FunctionATAN::ablStr(char* s) {
-	sprintf(s,"N(%i) [==f'(x)] %le*( sin(x+r) + (x+r)*cos(x+r) ) / ( 1+(x+r)^2*sin^2(x+r)",id,b);
-	return s;
+DualTerm dtDiv(const DualTerm& a,const DualTerm& b) {
+	if ((dtNull(a))||(dtEins(b))) return a;
+	return dtVerbinde(a,1,"/",b,0,1);
 }
 
-FunctionATAN::FunctionATAN() {
-    id = ID_FKT_ATAN;
-    b=2.7;
-    typ=FKTTYP_NORMAL;
+DualTerm dtQuadrat(const DualTerm& a) {
+	return dtVerbinde(a,0,"^",DualTerm("2"),0,0);
 }
 
-void FunctionATAN::eval(const double x,const double r,double& fx) {
-	const double xr=x+r;
-	fx=b*atan(xr*fastsin(xr));
+DualText::DualText(const double c) : d("0") {
+	char s[64];
+	sprintf(s,"%g",c);
+	v=DualTerm(s,(c<0) ? 2 : 0);
 }
 
-void FunctionATAN::save(FILE *f) {
-	fprintf(f,"ID\n%i\n#FUNCTION ATAN\nB\n%le\n",id,b);
+inline DualText operator+(const DualText& a,const DualText& b) { return DualText(dtAdd(a.v,b.v),dtAdd(a.d,b.d)); }
+inline DualText operator+(const DualText& a,const double b) { return a+DualText(b); }
+inline DualText operator+(const double a,const DualText& b) { return DualText(a)+b; }
+inline DualText operator-(const DualText& a) { return DualText(dtNeg(a.v),dtNeg(a.d)); }
+inline DualText operator-(const DualText& a,const DualText& b) { return DualText(dtSub(a.v,b.v),dtSub(a.d,b.d)); }
+inline DualText operator-(const DualText& a,const double b) { return a-DualText(b); }
+inline DualText operator-(const double a,const DualText& b) { return DualText(a)-b; }
+inline DualText operator*(const DualText& a,const DualText& b) {
+	return DualText(dtMul(a.v,b.v),dtAdd(dtMul(a.d,b.v),dtMul(a.v,b.d)));
+}
+inline DualText operator*(const DualText& a,const double b) { return a*DualText(b); }
+inline DualText operator*(const double a,const DualText& b) { return DualText(a)*b; }
+inline DualText operator/(const DualText& a,const DualText& b) {
+	return DualText(dtDiv(a.v,b.v),dtDiv(dtSub(dtMul(a.d,b.v),dtMul(a.v,b.d)),dtQuadrat(b.v)));
 }
 
-void FunctionATAN::eval(const double x,const double r,double& fx,double& abl) {
-	const double xr=x+r;
-	const double si=fastsin(xr);
-	const double xsi=xr*si;
-	fx=b*atan(xsi);
-	abl=b*(si+xr*fastcos(xr))/(1+xsi*xsi);
+template<int32_t TIER> inline DualText fktsin(const DualText& x) {
+	return DualText(dtFkt("sin",x.v),dtMul(dtFkt("cos",x.v),x.d));
 }
 
-void FunctionATAN::evalabl(const double x,const double r,double& abl) {
-	const double xr=x+r;
-	const double si=fastsin(xr);
-	const double xsi=xr*si;
-	abl=b*(si+xr*fastcos(xr))/(1+xsi*xsi);
+template<int32_t TIER> inline DualText fktcos(const DualText& x) {
+	return DualText(dtFkt("cos",x.v),dtNeg(dtMul(dtFkt("sin",x.v),x.d)));
 }
 
+inline DualText fktatan(const DualText& x) {
+	return DualText(dtFkt("atan",x.v),dtDiv(x.d,dtAdd(DualTerm("1"),dtQuadrat(x.v))));
+}
 
-// Function II
 
-char* FunctionII::fktStr(char* s) {
-	sprintf(s,"N(%i) %le*sin^2(x+r)",id,b);
-	return s;
-}
+// instruction set dispatch
 
-char* FunctionII::ablStr(char* s) {
-	sprintf(s,"N(%i) [==f'(x)] %lf*sin(x+r)*cos(x+r)",id,b2);
-	return s;
+ISALANES(lanesevalsse2,ISASSE2)
+ISALANES(lanesevalavx2,ISAAVX2)
+ISALANES(laneseval512,ISAAVX512)
+
+int32_t detectIsa(void) {
+	#ifdef ISADISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) return ISA_AVX512;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return ISA_AVX2;
+	#endif
+	return ISA_SSE2;
 }
 
-int32_t FunctionII::iterStart(void) {
-	if (!iterb) return 0; // gibt keinen
-	if (iterb->iterStart()<=0) return 0;
-	set_b(iterb->wert);
+int32_t setIsa(const int32_t i) {
+	// variants the cpu lacks are not selectable
+	if ((i<0)||(i>isadetected)) {
+		printf("Instruction set %i not supported, %s (%i) is the highest\n",i,ISANAMES[isadetected],isadetected);
+		return 0;
+	}
+	isa=i;
 	return 1;
 }
 
-int32_t FunctionII::iterWeiter(void) {
-	if (!iterb) return 0;
-	double w;
-	if (iterb->iterWeiter()) {
-		set_b(iterb->wert);
-		return 1;
+char* removeStr(const char* q,const char* was,char* erg) {
+	char* p=strstr(q,was);
+	if (p) {
+		for(int32_t i=0;i<(p-q);i++) erg[i]=q[i];
+		strcpy(&erg[p-q],p+strlen(was));
+	} else {
+		strcpy(erg,q);
 	}
 
-	return 0;
+	return erg;
 }
 
-FunctionII::FunctionII() {
-    id = ID_FKT_II;
-    b=2.7; b2=5.4;
+inline double maximumD(const double a,const double b) {
+	if (a > b) return a;
+
+	return b;
+}
+
+inline int32_t minimumI(const int32_t a,const int32_t b) {
+	if (a < b) return a;
+	return b;
+}
+
+inline int32_t maximumI(const int32_t a,const int32_t b) {
+	if (a > b) return a;
+	return b;
+}
+
+inline int64_t nanosec(void) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()
+	).count();
+}
+
+inline int64_t cpunanosec(void) {
+	// cpu time of the calling thread
+	#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts)==0) return (int64_t)ts.tv_sec*1000000000+ts.tv_nsec;
+	#endif
+	return 0;
+}
+
+int32_t fseek64(FILE* f,const int64_t pos) {
+	// from the start of the file, beyond 2 GB as well
+	#ifdef __linux__
+	return fseeko(f,pos,SEEK_SET);
+	#else
+	return _fseeki64(f,pos,SEEK_SET);
+	#endif
+}
+
+char* chomp(char* s) {
+	if (!s) return 0;
+	for(int32_t i=strlen(s);i>=0;i--) if (s[i]<32) s[i]=0; else break;
+	return s;
+}
+
+void writejson(FILE* f,const char* s) {
+	// s as JSON string literal with quotes
+	fputc('"',f);
+	for(;*s;s++) {
+		const unsigned char c=(unsigned char)*s;
+		if ((c=='"')||(c=='\\')) fprintf(f,"\\%c",c);
+		else if (c<32) fprintf(f,"\\u%04x",c);
+		else fputc(c,f);
+	}
+	fputc('"',f);
+}
+
+
+// struct CalcStats
+
+void CalcStats::clear(void) {
+	pixels=evals=logs=skipped=nanorbits=0;
+	for(int32_t i=0;i<ANZPHASES;i++) ns[i]=0;
+	cpuns=0;
+	for(int32_t i=0;i<ANZPHASES;i++) for(int32_t k=0;k<ANZPERF;k++) perf[i][k]=0;
+}
+
+void CalcStats::add(const CalcStats& c) {
+	pixels += c.pixels;
+	evals += c.evals;
+	logs += c.logs;
+	skipped += c.skipped;
+	nanorbits += c.nanorbits;
+	for(int32_t i=0;i<ANZPHASES;i++) ns[i] += c.ns[i];
+	cpuns += c.cpuns;
+	for(int32_t i=0;i<ANZPHASES;i++) for(int32_t k=0;k<ANZPERF;k++) perf[i][k] += c.perf[i][k];
+}
+
+
+// struct LambdaSketch
+
+void LambdaSketch::clear(void) {
+	for(int32_t i=0;i<SKETCHBINS;i++) neg[i]=pos[i]=0;
+	null=nan=anz=0;
+	minw=maxw=0;
+}
+
+void LambdaSketch::add(const double w) {
+	if (w!=w) { nan++; return; }
+	if ((anz==0)||(w<minw)) minw=w;
+	if ((anz==0)||(w>maxw)) maxw=w;
+	anz++;
+	const double a=fabs(w);
+	if (a<SKETCHMIN) { null++; return; }
+	int32_t i=(int32_t)(log(a/SKETCHMIN)/log(SKETCHGAMMA));
+	if (i>=SKETCHBINS) i=SKETCHBINS-1;
+	if (w<0) neg[i]++; else pos[i]++;
+}
+
+void LambdaSketch::merge(const LambdaSketch& s) {
+	if (s.anz>0) {
+		if ((anz==0)||(s.minw<minw)) minw=s.minw;
+		if ((anz==0)||(s.maxw>maxw)) maxw=s.maxw;
+	}
+	for(int32_t i=0;i<SKETCHBINS;i++) { neg[i] += s.neg[i]; pos[i] += s.pos[i]; }
+	null += s.null;
+	nan += s.nan;
+	anz += s.anz;
+}
+
+double LambdaSketch::quantil(const double q) const {
+	// middle of the bucket holding the value of rank q*(anz-1), NaN excluded
+	if (anz<=0) return 0;
+	const int64_t rang=(int64_t)(q*(anz-1));
+	int64_t summe=0;
+	double w=maxw;
+	int32_t gefunden=0;
+	for(int32_t i=SKETCHBINS-1;(i>=0)&&(!gefunden);i--) {
+		summe += neg[i];
+		if (summe>rang) { w=-SKETCHMIN*pow(SKETCHGAMMA,i+0.5); gefunden=1; }
+	}
+	if (!gefunden) {
+		summe += null;
+		if (summe>rang) { w=0; gefunden=1; }
+	}
+	for(int32_t i=0;(i<SKETCHBINS)&&(!gefunden);i++) {
+		summe += pos[i];
+		if (summe>rang) { w=SKETCHMIN*pow(SKETCHGAMMA,i+0.5); gefunden=1; }
+	}
+	if (w<minw) w=minw;
+	if (w>maxw) w=maxw;
+	return w;
+}
+
+
+// struct TraceSpan
+
+inline TraceSpan::TraceSpan(const char* aname,const int32_t aarg) {
+	if (!tracing) { name=NULL; return; }
+	name=aname;
+	arg=aarg;
+	ts=nanosec();
+}
+
+inline TraceSpan::~TraceSpan() {
+	if (!name) return;
+	const int64_t i=traceanz.fetch_add(1,std::memory_order_relaxed);
+	TraceEvent& e=traceevents[i % MAXTRACE];
+	e.name=name;
+	e.tid=tracetid;
+	e.arg=arg;
+	e.ts=ts;
+	e.dur=nanosec()-ts;
+}
+
+void setTrace(const int32_t an) {
+	// switching on starts a new timeline, switching off keeps it for SAVETRACE
+	if (an) {
+		if (!traceevents) traceevents=new TraceEvent[MAXTRACE];
+		traceanz=0;
+		tracet0=nanosec();
+	}
+	tracing=an;
+}
+
+int32_t saveTrace(const char* fn) {
+	// Chrome trace event format (chrome://tracing, ui.perfetto.dev)
+	if (!traceevents) { printf("No timeline recorded\n"); return 0; }
+	FILE *f=fopen(fn,"wt");
+	if (!f) { printf("Error writing %s\n",fn); return 0; }
+	const int64_t anz=traceanz;
+	const int64_t erster=(anz > MAXTRACE) ? anz-MAXTRACE : 0;
+	int32_t maxtid=0;
+	for(int64_t i=erster;i<anz;i++) if (traceevents[i % MAXTRACE].tid > maxtid) maxtid=traceevents[i % MAXTRACE].tid;
+	// names only for the threads that occur, worker ids are not reused
+	uint8_t* vorhanden=new uint8_t[maxtid+1];
+	memset(vorhanden,0,maxtid+1);
+	vorhanden[0]=1;
+	fprintf(f,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for(int64_t i=erster;i<anz;i++) {
+		const TraceEvent& e=traceevents[i % MAXTRACE];
+		vorhanden[e.tid]=1;
+		fprintf(f,"{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.3lf,\"dur\":%.3lf",
+			e.name,e.tid,(e.ts-tracet0)*1E-3,e.dur*1E-3);
+		if (e.arg>=0) fprintf(f,",\"args\":{\"nr\":%i}",e.arg);
+		fprintf(f,"},\n");
+	}
+	for(int32_t t=0;t<=maxtid;t++) {
+		if (!vorhanden[t]) continue;
+		if (t>0) fprintf(f,",\n");
+		fprintf(f,"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":",t);
+		if (t==0) fprintf(f,"\"main\"}}"); else fprintf(f,"\"worker %i\"}}",t);
+	}
+	fprintf(f,"\n]}\n");
+	delete[] vorhanden;
+	fclose(f);
+	printf("%lli events written",(long long)(anz-erster));
+	if (erster>0) printf(", %lli oldest ones overwritten",(long long)erster);
+	printf("\n");
+
+	return 1;
+}
+
+
+// struct PerfCounters
+
+int32_t PerfCounters::open(const uint64_t fpraw) {
+	// returns number of counters available, 0 if none (no Linux,
+	// no permission, virtual machine without PMU)
+	close();
+	#ifdef __linux__
+	const uint64_t config[ANZPERF]={
+		PERF_COUNT_HW_CPU_CYCLES,PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_BRANCH_INSTRUCTIONS,PERF_COUNT_HW_BRANCH_MISSES,PERF_COUNT_HW_CACHE_MISSES,fpraw
+	};
+	int32_t leader=-1;
+	for(int32_t i=0;i<ANZPERF;i++) {
+		if ((i==PERF_FP)&&(fpraw==0)) continue;
+		struct perf_event_attr pe;
+		memset(&pe,0,sizeof(pe));
+		pe.type=(i==PERF_FP) ? PERF_TYPE_RAW : PERF_TYPE_HARDWARE;
+		pe.size=sizeof(pe);
+		pe.config=config[i];
+		pe.disabled=(leader<0) ? 1 : 0;
+		pe.exclude_kernel=1;
+		pe.exclude_hv=1;
+		pe.read_format=PERF_FORMAT_GROUP;
+		int32_t f=syscall(__NR_perf_event_open,&pe,0,-1,leader,0);
+		if (f<0) continue;
+		if (leader<0) leader=f;
+		fd[i]=f;
+		gruppe[i]=anz++;
+	}
+	if (leader>=0) {
+		ioctl(leader,PERF_EVENT_IOC_RESET,PERF_IOC_FLAG_GROUP);
+		ioctl(leader,PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP);
+	}
+	#endif
+
+	return anz;
+}
+
+void PerfCounters::close(void) {
+	#ifdef __linux__
+	for(int32_t i=0;i<ANZPERF;i++) if (fd[i]>=0) ::close(fd[i]);
+	#endif
+	for(int32_t i=0;i<ANZPERF;i++) fd[i]=gruppe[i]=-1;
+	anz=0;
+}
+
+int32_t PerfCounters::read(uint64_t* w) {
+	// current values of all counters, 0 for unavailable ones
+	for(int32_t i=0;i<ANZPERF;i++) w[i]=0;
+	if (anz<=0) return 0;
+	#ifdef __linux__
+	uint64_t puffer[1+ANZPERF];
+	int32_t leader=-1;
+	for(int32_t i=0;i<ANZPERF;i++) if (gruppe[i]==0) leader=fd[i];
+	if (::read(leader,puffer,sizeof(puffer)) < (ssize_t)sizeof(uint64_t)) return 0;
+	for(int32_t i=0;i<ANZPERF;i++) if (gruppe[i]>=0) w[i]=puffer[1+gruppe[i]];
+	return 1;
+	#else
+	return 0;
+	#endif
+}
+
+
+// struct IterDouble
+
+IterDouble::IterDouble(const double a,const double b,const int32_t an) {
+	l=a; r=b;
+	anz=an;
+	if (an==1) delta=b-a; else delta=(b-a)/(an-1);
+	wert=l;
+	nr=0;
+}
+
+int32_t IterDouble::iterStart(void) {
+	wert=l;
+	nr=1;
+	return 1;
+}
+
+int32_t IterDouble::iterWeiter(void) {
+	wert+=delta;
+	nr++;
+	if (nr>anz) return 0;
+	return 1;
+}
+
+
+// Function LSIN
+
+char* FunctionLSIN::fktStr(char* s) {
+	sprintf(s,"N(%i) r*sin(x)*(1-%le*sin(x+r))",id,b);
+	return s;
+}
+
+FunctionLSIN::FunctionLSIN() {
+	id = ID_FKT_LSIN;
+	b=2.7;
+	typ=FKTTYP_NORMAL;
+}
+
+void FunctionLSIN::save(FILE *f) {
+	char tmp[1024];
+	fprintf(f,"ID\n%i\n#FUNCTION LSIN\nB\n%.17le\n",id,b);
+}
+
+template<int32_t TIER,class T,class R> inline T FunctionLSIN::fkt(const T& x,const R& r) {
+	return r*fktsin<TIER>(x)*(1.0-b*fktsin<TIER>(x+r));
+}
+
+DUALEVALDEF(FunctionLSIN)
+EVALVECDEF(FunctionLSIN)
+
+
+// Function ATAN
+
+char* FunctionATAN::fktStr(char* s) {
+	sprintf(s,"N(%i) %le*atan((x+r)*sin(x+r))",id,b);
+	return s;
+}
+
+FunctionATAN::FunctionATAN() {
+    id = ID_FKT_ATAN;
+    b=2.7;
     typ=FKTTYP_NORMAL;
 }
 
-void FunctionII::eval(const double x,const double r,double& fx) {
-	const double si=fastsin(x+r);
-	fx=b*si*si;
+void FunctionATAN::save(FILE *f) {
+	fprintf(f,"ID\n%i\n#FUNCTION ATAN\nB\n%.17le\n",id,b);
 }
 
-void FunctionII::eval(const double x,const double r,double& fx,double& abl) {
-	const double xr=x+r;
-	const double si=fastsin(xr);
-	fx=b*si*si;
-    abl=b2*si*fastcos(xr);
+template<int32_t TIER,class T,class R> inline T FunctionATAN::fkt(const T& x,const R& r) {
+	const T xr=x+r;
+	return b*fktatan(xr*fktsin<TIER>(xr));
+}
+
+DUALEVALDEF(FunctionATAN)
+EVALVECDEF(FunctionATAN)
+
+
+// Function II
+
+char* FunctionII::fktStr(char* s) {
+	sprintf(s,"N(%i) %le*sin^2(x+r)",id,b);
+	return s;
+}
+
+int32_t FunctionII::iterStart(void) {
+	if (!iterb) return 0; // gibt keinen
+	if (iterb->iterStart()<=0) return 0;
+	set_b(iterb->wert);
+	return 1;
+}
+
+int32_t FunctionII::iterWeiter(void) {
+	if (!iterb) return 0;
+	double w;
+	if (iterb->iterWeiter()) {
+		set_b(iterb->wert);
+		return 1;
+	}
+
+	return 0;
+}
+
+FunctionII::FunctionII() {
+    id = ID_FKT_II;
+    b=2.7; b2=5.4;
+    typ=FKTTYP_NORMAL;
 }
 
-void FunctionII::evalabl(const double x,const double r,double& abl) {
-	const double xr=x+r;
-    abl=b2*fastsin(xr)*fastcos(xr);
+template<int32_t TIER,class T,class R> inline T FunctionII::fkt(const T& x,const R& r) {
+	const T si=fktsin<TIER>(x+r);
+	return b*si*si;
 }
 
+DUALEVALDEF(FunctionII)
+EVALVECDEF(FunctionII)
+
 void FunctionII::save(FILE *f) {
-	fprintf(f,"ID\n%i\n#FUNCTION II\nB\n%le\n",id,b);
+	fprintf(f,"ID\n%i\n#FUNCTION II\nB\n%.17le\n",id,b);
+}
+
+void FunctionII::cachekey(FILE *f) {
+	// derived functions only add b to what they save
+	save(f);
+	fprintf(f,"B %a\n",b);
 }
 
 int32_t FunctionII::load(const int32_t aid,FILE *f) {
@@ -741,32 +2062,21 @@ char* FunctionIII::fktStr(char* s) {
 	return s;
 }
 
-char* FunctionIII::ablStr(char* s) {
-	sprintf(s,"N(%i) [==f'(x)] %le*sin(2*x)",id,b);
-	return s;
-}
-
 FunctionIII::FunctionIII() {
 	id = ID_FKT_III;
 	b=2.7; 
 	typ=FKTTYP_NORMAL;
 }
 
-void FunctionIII::eval(const double x,const double r,double& fx) {
-	fx=b*fastsin(x+r)*fastsin(x-r);
-}
-
-void FunctionIII::eval(const double x,const double r,double& fx,double& abl) {
-	fx=b*fastsin(x+r)*fastsin(x-r);
-	abl=b*fastsin(x+x);
+template<int32_t TIER,class T,class R> inline T FunctionIII::fkt(const T& x,const R& r) {
+	return b*fktsin<TIER>(x+r)*fktsin<TIER>(x-r);
 }
 
-void FunctionIII::evalabl(const double x,const double r,double& abl) {
-	abl=b*fastsin(x+x);
-}
+DUALEVALDEF(FunctionIII)
+EVALVECDEF(FunctionIII)
 
 void FunctionIII::save(FILE *f) {
-	fprintf(f,"ID\n%i\n#FUNCTION III\nB\n%le\n",id,b);
+	fprintf(f,"ID\n%i\n#FUNCTION III\nB\n%.17le\n",id,b);
 }
 
 
@@ -783,13 +2093,13 @@ FunctionVII::FunctionVII() {
 	typ=FKTTYP_DETACHED;
 }
 
-void FunctionVII::eval(const double x,const double r,double& fx) {
-	const double si=fastsin(x+r);
+template<int32_t TIER> inline void FunctionVII::evalT(const double x,const double r,double& fx) {
+	const double si=tiersin<TIER>(x+r);
 	fx=b*si*si;
 }
 
-void FunctionVII::eval(const double x,const double r,double& fx,double& abl) {
-	const double si=fastsin(x+r);
+template<int32_t TIER> inline void FunctionVII::evalT(const double x,const double r,double& fx,double& abl) {
+	const double si=tiersin<TIER>(x+r);
 	fx=b*si*si;
 	const double rx=r*x;
 	abl=r-rx-rx;
@@ -801,13 +2111,16 @@ void FunctionVII::evalabl(const double x,const double r,double& abl) {
 	abl=r-rx-rx;
 }
 
+TIEREVALDEF(FunctionVII)
+EVALVECDEF(FunctionVII)
+
 char* FunctionVII::ablStr(char* s) {
 	sprintf(s,"DET(%i) r-2rx",id);
 	return s;
 }
 
 void FunctionVII::save(FILE *f) {
-	fprintf(f,"ID\n%i\n#DETACHED FUNCTION VII\nB\n%le\n",id,b);
+	fprintf(f,"ID\n%i\n#DETACHED FUNCTION VII\nB\n%.17le\n",id,b);
 }
 
 
@@ -824,15 +2137,15 @@ FunctionIX::FunctionIX() {
 	typ=FKTTYP_DETACHED;
 }
 
-void FunctionIX::eval(const double x,const double r,double& fx) {
-	const double si=fastsin(b*x+r);
-	fx=b*fastsin(x+r)+b*si*si;
+template<int32_t TIER> inline void FunctionIX::evalT(const double x,const double r,double& fx) {
+	const double si=tiersin<TIER>(b*x+r);
+	fx=b*tiersin<TIER>(x+r)+b*si*si;
 }
 
-void FunctionIX::eval(const double x,const double r,double& fx,double& abl) {
-	const double si=fastsin(b*x+r);
-	fx=b*fastsin(x+r)+b*si*si;
-	const double si2=fastsin(x+r*b);
+template<int32_t TIER> inline void FunctionIX::evalT(const double x,const double r,double& fx,double& abl) {
+	const double si=tiersin<TIER>(b*x+r);
+	fx=b*tiersin<TIER>(x+r)+b*si*si;
+	const double si2=tiersin<TIER>(x+r*b);
 	abl=si2*si2-r*x;
 }
 
@@ -842,13 +2155,16 @@ void FunctionIX::evalabl(const double x,const double r,double& abl) {
 	abl=si2*si2-r*x;
 }
 
+TIEREVALDEF(FunctionIX)
+EVALVECDEF(FunctionIX)
+
 char* FunctionIX::ablStr(char* s) {
 	sprintf(s,"DET(%i) sin^2(x%+le*r)-r*x",id,b);
 	return s;
 }
 
 void FunctionIX::save(FILE *f) {
-	fprintf(f,"ID\n%i\n#DETACHED FUNCTION IX\nB\n%le\n",id,b);
+	fprintf(f,"ID\n%i\n#DETACHED FUNCTION IX\nB\n%.17le\n",id,b);
 }
 
 
@@ -865,18 +2181,18 @@ FunctionX::FunctionX() {
 	typ=FKTTYP_DETACHED;
 }
 
-void FunctionX::eval(const double x,const double r,double& fx) {
-	const double si=fastsin(x-r);
-	const double si2=fastsin(x+r+r);
+template<int32_t TIER> inline void FunctionX::evalT(const double x,const double r,double& fx) {
+	const double si=tiersin<TIER>(x-r);
+	const double si2=tiersin<TIER>(x+r+r);
 	fx=r*si*si+b*si2*si2*si2;
 }
 
-void FunctionX::eval(const double x,const double r,double& fx,double& abl) {
-	const double si=fastsin(x-r);
-	const double si2=fastsin(x+r+r);
+template<int32_t TIER> inline void FunctionX::evalT(const double x,const double r,double& fx,double& abl) {
+	const double si=tiersin<TIER>(x-r);
+	const double si2=tiersin<TIER>(x+r+r);
 	fx=r*si*si+b*si2*si2*si2;
 	const double rx=r*x;
-	const double si3=fastsin(rx-b);
+	const double si3=tiersin<TIER>(rx-b);
 	const double si4=si3*si3;
 	abl=rx-b*si4*si4;
 }
@@ -888,13 +2204,16 @@ void FunctionX::evalabl(const double x,const double r,double& abl) {
 	abl=rx-b*si4*si4;
 }
 
+TIEREVALDEF(FunctionX)
+EVALVECDEF(FunctionX)
+
 char* FunctionX::ablStr(char* s) {
 	sprintf(s,"DET(%i) rx-%le*sin^4(rx-%le)",id,b,b);
 	return s;
 }
 
 void FunctionX::save(FILE *f) {
-	fprintf(f,"ID\n%i\n#DETACHED FUNCTION X\nB\n%le\n",id,b);
+	fprintf(f,"ID\n%i\n#DETACHED FUNCTION X\nB\n%.17le\n",id,b);
 }
 
 
@@ -987,6 +2306,26 @@ void FunctionMetaDet::eval(const double  x,const double  r,double & fx,double &
 	if (ablwas==WAS_F) abl->eval(x,r,ab); else abl->evalabl(x,r,ab);
 }
 
+void FunctionMetaDet::evalvec(const int32_t n,const double* x,const double* r,double* fx) {
+	double tmp;
+	if (fwas==WAS_F) f->evalvec(n,x,r,fx);
+	else for(int32_t i=0;i<n;i++) f->eval(x[i],r[i],tmp,fx[i]);
+}
+
+void FunctionMetaDet::evalvec(const int32_t n,const double* x,const double* r,double* fx,double* ab) {
+	if (fwas==WAS_F) f->evalvec(n,x,r,fx);
+	else for(int32_t i=0;i<n;i++) f->evalabl(x[i],r[i],fx[i]);
+	if (ablwas==WAS_F) abl->evalvec(n,x,r,ab);
+	else for(int32_t i=0;i<n;i++) abl->evalabl(x[i],r[i],ab[i]);
+}
+
+void FunctionMetaDet::cachekey(FILE *ff) {
+	fprintf(ff,"ID %i FWAS %i ABLWAS %i\nFKT\n",id,fwas,ablwas);
+	f->cachekey(ff);
+	fprintf(ff,"ABL\n");
+	abl->cachekey(ff);
+}
+
 void FunctionMetaDet::save(FILE *ff) {
 	fprintf(ff,"ID\n%i\n#METADET\nFWAS\n%i\nABLWAS\n%i\n",id,fwas,ablwas);
 	fprintf(ff,"#FKT\n");
@@ -1081,6 +2420,7 @@ FunctionMetaABSC::FunctionMetaABSC() {
     b=2.7; b2=b+b;
     fint=fext=NULL;
     typ=FKTTYP_ABSCHNITTSWEISE;
+    vecblocks=vecmixed=0;
 }
 
 void FunctionMetaABSC::eval(const double x,const double r,double& fx) {
@@ -1097,12 +2437,102 @@ void FunctionMetaABSC::eval(const double x,const double r,double& fx,double& abl
 	else fint->eval(x,r,fx,abl);
 }
 
+void FunctionMetaABSC::evalvec(const int32_t n,const double* x,const double* r,double* fx) {
+	evalsectionvec(n,x,r,fx,NULL,I0MIN,I0MAX);
+}
+
+void FunctionMetaABSC::evalvec(const int32_t n,const double* x,const double* r,double* fx,double* abl) {
+	evalsectionvec(n,x,r,fx,abl,I1MIN,I1MAX);
+}
+
+void FunctionMetaABSC::evalsectionvec(
+	const int32_t n,const double* x,const double* r,
+	double* fx,double* abl,
+	const double smin,const double smax
+) {
+	// abl==NULL: trajectory only
+	// lane mask: 1 if fint is to be used (same comparison as scalar eval)
+	int32_t innen[VECLEN];
+	int32_t anzinnen=0;
+	for(int32_t i=0;i<n;i++) {
+		innen[i]=((x[i] > smax) || (x[i] < smin)) ? 0 : 1;
+		anzinnen += innen[i];
+	}
+
+	// share of diverging blocks among all recent ones
+	const int32_t divergiert=((anzinnen>0)&&(anzinnen<n)) ? 1 : 0;
+	int32_t bl=vecblocks.load(std::memory_order_relaxed)+1;
+	int32_t mi=vecmixed.load(std::memory_order_relaxed)+divergiert;
+	if (bl >= DIVERGENCEWINDOW) {
+		// decay so the heuristic follows the current image region
+		bl >>= 1;
+		mi >>= 1;
+	}
+	vecblocks.store(bl,std::memory_order_relaxed);
+	vecmixed.store(mi,std::memory_order_relaxed);
+
+	// all lanes agree: only one side is evaluated
+	if (anzinnen==n) {
+		if (abl) fint->evalvec(n,x,r,fx,abl); else fint->evalvec(n,x,r,fx);
+		return;
+	}
+	if (anzinnen==0) {
+		if (abl) fext->evalvec(n,x,r,fx,abl); else fext->evalvec(n,x,r,fx);
+		return;
+	}
+
+	// lanes diverge
+	if ((mi*DIVERGENCEBLEND) > bl) {
+		// frequent divergence: evaluate both sides for all lanes and blend per lane
+		double fi[VECLEN],fe[VECLEN],ai[VECLEN],ae[VECLEN];
+		if (abl) {
+			fint->evalvec(n,x,r,fi,ai);
+			fext->evalvec(n,x,r,fe,ae);
+			for(int32_t i=0;i<n;i++) {
+				fx[i] = innen[i] ? fi[i] : fe[i];
+				abl[i] = innen[i] ? ai[i] : ae[i];
+			}
+		} else {
+			fint->evalvec(n,x,r,fi);
+			fext->evalvec(n,x,r,fe);
+			for(int32_t i=0;i<n;i++) fx[i] = innen[i] ? fi[i] : fe[i];
+		}
+		return;
+	}
+
+	// rare divergence: branch, i.e. gather the lanes of each side
+	// and evaluate every lane only once
+	double gx[VECLEN],gr[VECLEN],gf[VECLEN],ga[VECLEN];
+	int32_t idx[VECLEN];
+	for(int32_t seite=1;seite>=0;seite--) {
+		int32_t m=0;
+		for(int32_t i=0;i<n;i++) if (innen[i]==seite) {
+			idx[m]=i; gx[m]=x[i]; gr[m]=r[i]; m++;
+		}
+		Function* p = seite ? fint : fext;
+		if (abl) {
+			p->evalvec(m,gx,gr,gf,ga);
+			for(int32_t i=0;i<m;i++) { fx[idx[i]]=gf[i]; abl[idx[i]]=ga[i]; }
+		} else {
+			p->evalvec(m,gx,gr,gf);
+			for(int32_t i=0;i<m;i++) fx[idx[i]]=gf[i];
+		}
+	}
+}
+
+void FunctionMetaABSC::cachekey(FILE *ff) {
+	fprintf(ff,"ID %i I0 %a %a I1 %a %a\nFINT\n",id,I0MIN,I0MAX,I1MIN,I1MAX);
+	fint->cachekey(ff);
+	fprintf(ff,"FEXT\n");
+	fext->cachekey(ff);
+}
+
 void FunctionMetaABSC::save(FILE *ff) {
 	fprintf(ff,"ID\n%i\n#METAABSC\n",id);
-	fprintf(ff,"I0MIN\n%le\n",I0MIN);
-	fprintf(ff,"I0MAX\n%le\n",I0MAX);
-	fprintf(ff,"I1MIN\n%le\n",I1MIN);
-	fprintf(ff,"I1MAX\n%le\n",I1MAX);
+	fprintf(ff,"I0MIN\n%.17le\n",I0MIN);
+	fprintf(ff,"I0MAX\n%.17le\n",I0MAX);
+	fprintf(ff,"I1MIN\n%.17le\n",I1MIN);
+	fprintf(ff,"I1MAX\n%.17le\n",I1MAX);
 	fprintf(ff,"FINT\n");
 	fint->save(ff);
 	fprintf(ff,"FEXT\n");
@@ -1141,30 +2571,15 @@ FunctionSICO::FunctionSICO() {
     typ=FKTTYP_NORMAL;
 }
 
-void FunctionSICO::evalabl(const double x,const double r,double& abl) {
-	const double xr=x+r;
-	const double xrc=x+r*fastcos(xr);
-	abl=b*(1-r*fastsin(xr))*fastcos(xrc);
-}
-
-void FunctionSICO::eval(const double x,const double r,double& fx) {
-	fx=b*fastsin(x+r*fastcos(x+r));
+template<int32_t TIER,class T,class R> inline T FunctionSICO::fkt(const T& x,const R& r) {
+	return b*fktsin<TIER>(x+r*fktcos<TIER>(x+r));
 }
 
-void FunctionSICO::eval(const double x,const double r,double& fx,double& abl) {
-	const double xr=x+r;
-	const double xrc=x+r*fastcos(xr);
-	fx=b*fastsin(xrc);
-	abl=b*(1-r*fastsin(xr))*fastcos(xrc);
-}
-
-char* FunctionSICO::ablStr(char* s) {
-	sprintf(s,"N(%i) [==f'(x)] %le*(1-r*sin(x+r))*cos(x+r*cos(x+r))",id,b);
-	return s;
-}
+DUALEVALDEF(FunctionSICO)
+EVALVECDEF(FunctionSICO)
 
 void FunctionSICO::save(FILE *f) {
-	fprintf(f,"ID\n%i\n#FUNCTION SICO\nB\n%le\n",id,b);
+	fprintf(f,"ID\n%i\n#FUNCTION SICO\nB\n%.17le\n",id,b);
 }
 
 int32_t FunctionSICO::load(const int32_t aid,FILE *f) {
@@ -1187,30 +2602,446 @@ int32_t FunctionSICO::load(const int32_t aid,FILE *f) {
 }
 
 
-// Function I
+// Formula compiler
+
+inline double formulaop(const int32_t op,const double a,const double b) {
+	switch (op) {
+		case FOP_NEG: return -a;
+		case FOP_ADD: return a+b;
+		case FOP_SUB: return a-b;
+		case FOP_MUL: return a*b;
+		case FOP_DIV: return a/b;
+		case FOP_POW: return pow(a,b);
+		case FOP_SIN: return fastsin(a);
+		case FOP_COS: return fastcos(a);
+		case FOP_TAN: return tan(a);
+		case FOP_ATAN: return atan(a);
+		case FOP_EXP: return exp(a);
+		case FOP_LOG: return log(a);
+		case FOP_SQRT: return sqrt(a);
+		case FOP_ABS: return fabs(a);
+	}
 
-FunctionI::FunctionI() {
-	id = ID_FKT_I;
-    typ=FKTTYP_NORMAL;
+	return 0;
 }
 
-void FunctionI::eval(const double x,const double r,double &fx) { 
-	fx=r*x*(1-x); 
+int32_t FormulaCompiler::node(const int32_t op,const int32_t aa,const int32_t ab,const double w) {
+	if (fehler) return 0;
+	int32_t a=aa,b=ab;
+
+	// constant folding
+	if (op>=FOP_NEG) {
+		int32_t acon=(nodes[a].op==FOP_CONST);
+		int32_t bcon=(op<FOP_SIN) && (op!=FOP_NEG) ? (nodes[b].op==FOP_CONST) : 1;
+		if (acon && bcon) {
+			return node(FOP_CONST,0,0,formulaop(op,nodes[a].wert,(op<FOP_SIN)&&(op!=FOP_NEG) ? nodes[b].wert : 0));
+		}
+		// neutral elements
+		if ((op==FOP_MUL)&&(nodes[a].op==FOP_CONST)&&(nodes[a].wert==1.0)) return b;
+		if ((op==FOP_MUL)&&(nodes[b].op==FOP_CONST)&&(nodes[b].wert==1.0)) return a;
+		if ((op==FOP_ADD)&&(nodes[a].op==FOP_CONST)&&(nodes[a].wert==0.0)) return b;
+		if (((op==FOP_ADD)||(op==FOP_SUB))&&(nodes[b].op==FOP_CONST)&&(nodes[b].wert==0.0)) return a;
+		if ((op==FOP_POW)&&(nodes[b].op==FOP_CONST)) {
+			const double e=nodes[b].wert;
+			if ((e==floor(e))&&(fabs(e)<=16)) {
+				int32_t p=powint(a,(int32_t)fabs(e));
+				if (e<0) return node(FOP_DIV,node(FOP_CONST,0,0,1.0),p,0);
+				return p;
+			}
+		}
+		// commutative: canonical operand order for common subexpressions
+		if (((op==FOP_ADD)||(op==FOP_MUL))&&(a>b)) { int32_t t=a; a=b; b=t; }
+	}
+	if (op<FOP_NEG) { a=b=0; }
+	if ((op>=FOP_SIN)||(op==FOP_NEG)) b=0;
+
+	// common subexpressions
+	for(int32_t i=0;i<anznodes;i++) {
+		if ((nodes[i].op==op)&&(nodes[i].a==a)&&(nodes[i].b==b)) {
+			if ((op!=FOP_CONST)||(nodes[i].wert==w)) return i;
+		}
+	}
+
+	if (anznodes>=MAXFORMULANODES) {
+		printf("Formula too long\n");
+		fehler=1;
+		return 0;
+	}
+	nodes[anznodes].op=op;
+	nodes[anznodes].a=a;
+	nodes[anznodes].b=b;
+	nodes[anznodes].wert=w;
+
+	return anznodes++;
+}
+
+int32_t FormulaCompiler::powint(const int32_t a,const int32_t e) {
+	// square and multiply, the squares are shared nodes
+	if (e==0) return node(FOP_CONST,0,0,1.0);
+	if (e==1) return a;
+	int32_t h=powint(a,e >> 1);
+	int32_t q=node(FOP_MUL,h,h,0);
+	if (e & 1) return node(FOP_MUL,q,a,0);
+	return q;
+}
+
+int32_t FormulaCompiler::parseExpr(void) {
+	int32_t a=parseTerm();
+	while (!fehler) {
+		skipSpace();
+		if (*pos=='+') { pos++; a=node(FOP_ADD,a,parseTerm(),0); }
+		else if (*pos=='-') { pos++; a=node(FOP_SUB,a,parseTerm(),0); }
+		else break;
+	}
+
+	return a;
 }
 
-void FunctionI::eval(const double x,const double r,double &fx,double &abl) {
-	const double rx=r*x;
-	fx=rx*(1-x);
-    abl=r-rx-rx;
+int32_t FormulaCompiler::parseTerm(void) {
+	int32_t a=parseUnary();
+	while (!fehler) {
+		skipSpace();
+		if (*pos=='*') { pos++; a=node(FOP_MUL,a,parseUnary(),0); }
+		else if (*pos=='/') { pos++; a=node(FOP_DIV,a,parseUnary(),0); }
+		else break;
+	}
+
+	return a;
 }
 
-void FunctionI::evalabl(const double x,const double r,double &abl) {
-	const double rx=r*x;
-	abl=r-rx-rx;
+int32_t FormulaCompiler::parseUnary(void) {
+	skipSpace();
+	if (*pos=='-') { pos++; return node(FOP_NEG,parseUnary(),0,0); }
+	if (*pos=='+') { pos++; return parseUnary(); }
+
+	return parsePower();
 }
 
-void FunctionI::save(FILE *f) {
-	fprintf(f,"ID\n%i\n#FUNCTION I\n",id);
+int32_t FormulaCompiler::parsePower(void) {
+	int32_t a=parsePrimary();
+	skipSpace();
+	// right associative, -x^2 = -(x^2)
+	if (*pos=='^') { pos++; return node(FOP_POW,a,parseUnary(),0); }
+
+	return a;
+}
+
+int32_t FormulaCompiler::parsePrimary(void) {
+	if (fehler) return 0;
+	skipSpace();
+
+	if (*pos=='(') {
+		pos++;
+		int32_t a=parseExpr();
+		skipSpace();
+		if (*pos!=')') { printf("Formula: ) expected at %s\n",pos); fehler=1; return 0; }
+		pos++;
+		return a;
+	}
+
+	if (((*pos>='0')&&(*pos<='9'))||(*pos=='.')) {
+		char* e;
+		double w=strtod(pos,&e);
+		pos=e;
+		return node(FOP_CONST,0,0,w);
+	}
+
+	char name[16];
+	int32_t l=0;
+	while ((*pos>='A')&&(*pos<='Z')&&(l<15)) name[l++]=*pos++;
+	name[l]=0;
+
+	if (strcmp(name,"X")==0) return node(FOP_X,0,0,0);
+	if (strcmp(name,"R")==0) return node(FOP_R,0,0,0);
+	if (strcmp(name,"B")==0) return node(FOP_B,0,0,0);
+	if (strcmp(name,"PI")==0) return node(FOP_CONST,0,0,M_PI);
+
+	int32_t op=0;
+	if (strcmp(name,"SIN")==0) op=FOP_SIN;
+	else if (strcmp(name,"COS")==0) op=FOP_COS;
+	else if (strcmp(name,"TAN")==0) op=FOP_TAN;
+	else if (strcmp(name,"ATAN")==0) op=FOP_ATAN;
+	else if (strcmp(name,"EXP")==0) op=FOP_EXP;
+	else if (strcmp(name,"LOG")==0) op=FOP_LOG;
+	else if (strcmp(name,"SQRT")==0) op=FOP_SQRT;
+	else if (strcmp(name,"ABS")==0) op=FOP_ABS;
+	else {
+		printf("Formula: unknown symbol %s\n",name);
+		fehler=1;
+		return 0;
+	}
+
+	skipSpace();
+	if (*pos!='(') { printf("Formula: ( expected after %s\n",name); fehler=1; return 0; }
+	pos++;
+	int32_t a=parseExpr();
+	skipSpace();
+	if (*pos!=')') { printf("Formula: ) expected at %s\n",pos); fehler=1; return 0; }
+	pos++;
+
+	return node(op,a,0,0);
+}
+
+int32_t FormulaCompiler::parseAll(const char* s) {
+	char tmp[MAXFORMULALEN];
+	strncpy(tmp,s,MAXFORMULALEN-1);
+	tmp[MAXFORMULALEN-1]=0;
+	upper(tmp);
+	pos=tmp;
+	int32_t a=parseExpr();
+	skipSpace();
+	if ((!fehler)&&(*pos!=0)) {
+		printf("Formula: unexpected %s\n",pos);
+		fehler=1;
+	}
+	pos=NULL;
+
+	return a;
+}
+
+int32_t FormulaCompiler::compile(const char* fs,const char* gs,FormulaProgram& prog) {
+	// gs==NULL: trajectory only
+	anznodes=0;
+	fehler=0;
+	int32_t rootf=parseAll(fs);
+	int32_t rootg=-1;
+	if (gs) rootg=parseAll(gs);
+	if (fehler) return 0;
+
+	// reachable nodes in topological order (children have smaller indices)
+	int32_t benutzt[MAXFORMULANODES],letzte[MAXFORMULANODES];
+	int32_t reg[MAXFORMULANODES]={ 0 };
+	for(int32_t i=0;i<anznodes;i++) { benutzt[i]=0; letzte[i]=-1; }
+	benutzt[rootf]=1;
+	if (rootg>=0) benutzt[rootg]=1;
+	for(int32_t i=anznodes-1;i>=0;i--) if (benutzt[i]) {
+		const int32_t op=nodes[i].op;
+		if (op>=FOP_NEG) benutzt[nodes[i].a]=1;
+		if ((op>=FOP_ADD)&&(op<FOP_SIN)) benutzt[nodes[i].b]=1;
+	}
+	for(int32_t i=0;i<anznodes;i++) if (benutzt[i]) {
+		const int32_t op=nodes[i].op;
+		if (op>=FOP_NEG) letzte[nodes[i].a]=i;
+		if ((op>=FOP_ADD)&&(op<FOP_SIN)) letzte[nodes[i].b]=i;
+	}
+	// outputs stay alive
+	letzte[rootf]=anznodes;
+	if (rootg>=0) letzte[rootg]=anznodes;
+
+	// inputs and constants are read in place, the remaining nodes
+	// get working registers by linear scan allocation
+	int32_t frei[MAXFORMULAREG],anzfrei=0;
+	prog.anzinstr=prog.anzreg=prog.anzbank=0;
+	prog.bankb=-1;
+	for(int32_t i=0;i<anznodes;i++) if (benutzt[i]) {
+		const int32_t op=nodes[i].op;
+		if ((op==FOP_X)||(op==FOP_R)) {
+			reg[i]=(op==FOP_X) ? FORMULAREGX : FORMULAREGR;
+			continue;
+		}
+		if ((op==FOP_CONST)||(op==FOP_B)) {
+			if (prog.anzbank>=MAXFORMULAREG) {
+				printf("Formula has too many constants\n");
+				return 0;
+			}
+			if (op==FOP_B) prog.bankb=prog.anzbank;
+			for(int32_t l=0;l<VECLEN;l++) prog.bank[prog.anzbank][l]=nodes[i].wert;
+			reg[i]=FORMULAREGBANK+prog.anzbank;
+			prog.anzbank++;
+			continue;
+		}
+
+		FormulaInstr& in=prog.instr[prog.anzinstr++];
+		in.op=op;
+		in.wert=nodes[i].wert;
+		in.a=reg[nodes[i].a];
+		in.b=((op>=FOP_ADD)&&(op<FOP_SIN)) ? reg[nodes[i].b] : in.a;
+		// operands dying here free their register, elementwise ops
+		// may write into an operand register
+		if ((in.a<MAXFORMULAREG)&&(letzte[nodes[i].a]==i)) frei[anzfrei++]=in.a;
+		if ((op>=FOP_ADD)&&(op<FOP_SIN)&&(in.b<MAXFORMULAREG)&&(nodes[i].b!=nodes[i].a)&&(letzte[nodes[i].b]==i)) frei[anzfrei++]=in.b;
+		if (anzfrei>0) reg[i]=frei[--anzfrei];
+		else {
+			if (prog.anzreg>=MAXFORMULAREG) {
+				printf("Formula needs too many registers\n");
+				return 0;
+			}
+			reg[i]=prog.anzreg++;
+		}
+		in.dst=reg[i];
+	}
+	prog.regf=reg[rootf];
+	prog.regg=(rootg>=0) ? reg[rootg] : -1;
+
+	return 1;
+}
+
+template<int32_t N,int32_t TIER>
+inline void formularun(
+	const FormulaProgram& prog,const int32_t n,
+	const double* x,const double* r,
+	double* fx,double* gx
+) {
+	// N>0: lane count known at compile time (full blocks), else n
+	const int32_t nl=(N>0) ? N : n;
+	double reg[MAXFORMULAREG][VECLEN];
+	const double* op[FORMULAREGBANK+MAXFORMULAREG];
+	for(int32_t i=0;i<prog.anzreg;i++) op[i]=reg[i];
+	op[FORMULAREGX]=x;
+	op[FORMULAREGR]=r;
+	for(int32_t i=0;i<prog.anzbank;i++) op[FORMULAREGBANK+i]=prog.bank[i];
+
+	// the dispatch is paid once per instruction for all lanes
+	for(int32_t k=0;k<prog.anzinstr;k++) {
+		const FormulaInstr& in=prog.instr[k];
+		double* d=reg[in.dst];
+		const double* a=op[in.a];
+		const double* c=op[in.b];
+		switch (in.op) {
+			case FOP_NEG: for(int32_t l=0;l<nl;l++) d[l]=-a[l]; break;
+			case FOP_ADD: for(int32_t l=0;l<nl;l++) d[l]=a[l]+c[l]; break;
+			case FOP_SUB: for(int32_t l=0;l<nl;l++) d[l]=a[l]-c[l]; break;
+			case FOP_MUL: for(int32_t l=0;l<nl;l++) d[l]=a[l]*c[l]; break;
+			case FOP_DIV: for(int32_t l=0;l<nl;l++) d[l]=a[l]/c[l]; break;
+			case FOP_SIN: for(int32_t l=0;l<nl;l++) d[l]=tiersin<TIER>(a[l]); break;
+			case FOP_COS: for(int32_t l=0;l<nl;l++) d[l]=tiercos<TIER>(a[l]); break;
+			default: for(int32_t l=0;l<nl;l++) d[l]=formulaop(in.op,a[l],c[l]); break;
+		}
+	}
+
+	const double* ef=op[prog.regf];
+	for(int32_t l=0;l<nl;l++) fx[l]=ef[l];
+	if (gx) {
+		const double* eg=op[prog.regg];
+		for(int32_t l=0;l<nl;l++) gx[l]=eg[l];
+	}
+}
+
+ISAFORMULA(formularunsse2,ISASSE2)
+ISAFORMULA(formularunavx2,ISAAVX2)
+ISAFORMULA(formularun512,ISAAVX512)
+
+void FormulaProgram::run(
+	const int32_t n,const double* x,const double* r,
+	double* fx,double* gx
+) {
+	switch (isa) {
+		case ISA_AVX512: formularun512(*this,n,x,r,fx,gx); return;
+		case ISA_AVX2: formularunavx2(*this,n,x,r,fx,gx); return;
+	}
+	formularunsse2(*this,n,x,r,fx,gx);
+}
+
+void FormulaProgram::set_b(const double w) {
+	if (bankb>=0) for(int32_t l=0;l<VECLEN;l++) bank[bankb][l]=w;
+}
+
+
+// Function Formula
+
+FunctionFormula::FunctionFormula() {
+	id = ID_FKT_FORMULA;
+	b=2.7; b2=b+b;
+	typ=FKTTYP_DETACHED;
+	fstr[0]=gstr[0]=0;
+}
+
+int32_t FunctionFormula::setformula(const char* fs,const char* gs) {
+	if ((strlen(fs)>=MAXFORMULALEN)||(strlen(gs)>=MAXFORMULALEN)) {
+		printf("Formula longer than %i characters\n",MAXFORMULALEN-1);
+		return 0;
+	}
+	FormulaCompiler comp;
+	if (comp.compile(fs,NULL,progf) <= 0) return 0;
+	if (comp.compile(fs,gs,progfg) <= 0) return 0;
+	strncpy(fstr,fs,MAXFORMULALEN-1); fstr[MAXFORMULALEN-1]=0;
+	strncpy(gstr,gs,MAXFORMULALEN-1); gstr[MAXFORMULALEN-1]=0;
+	set_b(b);
+
+	return 1;
+}
+
+void FunctionFormula::set_b(const double d) {
+	b=d; b2=d+d;
+	progf.set_b(d);
+	progfg.set_b(d);
+}
+
+char* FunctionFormula::fktStr(char* s) {
+	sprintf(s,"F(%i) %s with b=%le",id,fstr,b);
+	return s;
+}
+
+char* FunctionFormula::ablStr(char* s) {
+	sprintf(s,"F(%i) %s with b=%le",id,gstr,b);
+	return s;
+}
+
+void FunctionFormula::eval(const double x,const double r,double& fx) {
+	progf.run(1,&x,&r,&fx,NULL);
+}
+
+void FunctionFormula::eval(const double x,const double r,double& fx,double& abl) {
+	progfg.run(1,&x,&r,&fx,&abl);
+}
+
+void FunctionFormula::evalabl(const double x,const double r,double& abl) {
+	double fx;
+	progfg.run(1,&x,&r,&fx,&abl);
+}
+
+void FunctionFormula::evalvec(const int32_t n,const double* x,const double* r,double* fx) {
+	progf.run(n,x,r,fx,NULL);
+}
+
+void FunctionFormula::evalvec(const int32_t n,const double* x,const double* r,double* fx,double* abl) {
+	progfg.run(n,x,r,fx,abl);
+}
+
+void FunctionFormula::save(FILE *f) {
+	fprintf(f,"ID\n%i\n#FORMULA\nF\n%s\nG\n%s\nB\n%.17le\n",id,fstr,gstr,b);
+}
+
+int32_t FunctionFormula::load(const int32_t aid,FILE *f) {
+	if (aid!=id) { return 0; }
+
+	int32_t pnotw=3,param=0;
+    char puffer[1000],fs[1000],gs[1000];
+    double w; 
+	int32_t i=0;
+	fs[0]=gs[0]=0;
+    while (i<pnotw) {
+		fgets(puffer,1000,f); chomp(puffer);
+		upper(puffer);
+		if (puffer[0]=='#') continue; // Bemerkung
+        else i++;
+        if (strcmp(puffer,"B")==0) { fscanf(f,"%le\n",&w); param++; set_b(w); }
+        else if (strcmp(puffer,"F")==0) { fgets(fs,1000,f); chomp(fs); param++; }
+        else if (strcmp(puffer,"G")==0) { fgets(gs,1000,f); chomp(gs); param++; }
+	}
+    if (param!=pnotw) return -1;
+	if (setformula(fs,gs) <= 0) { printf("Error in formula\n"); return -1; }
+
+	return 1;
+}
+
+
+// Function I
+
+FunctionI::FunctionI() {
+	id = ID_FKT_I;
+    typ=FKTTYP_NORMAL;
+}
+
+template<int32_t TIER,class T,class R> inline T FunctionI::fkt(const T& x,const R& r) {
+	return r*x*(1.0-x);
+}
+
+DUALEVALDEF(FunctionI)
+EVALVECDEF(FunctionI)
+
+void FunctionI::save(FILE *f) {
+	fprintf(f,"ID\n%i\n#FUNCTION I\n",id);
 }
 
 int32_t FunctionI::load(const int32_t aid,FILE *) {
@@ -1365,6 +3196,10 @@ IntervalColoring::~IntervalColoring() {
 	clear();
 }
 
+ISACOLOR(colorsse2,ISASSE2)
+ISACOLOR(coloravx2,ISAAVX2)
+ISACOLOR(color512,ISAAVX512)
+
 
 // struct ljapunow
 
@@ -1376,6 +3211,8 @@ int32_t Ljapunow::loadpar(char *fn) {
     int32_t pnotw=11,param=0,tlenx=0,tleny=0;
     int32_t tmpiter0=100,tmpiter1=200;
     double w1,w2; 
+	precision=PRECISION_DOUBLE;
+	cwert=0.0;
 	while (!feof(f)) {
 		fgets(puffer,1000,f); chomp(puffer);
         if ((puffer[0]=='#')||(puffer[0]=='.')) continue;
@@ -1428,6 +3265,15 @@ int32_t Ljapunow::loadpar(char *fn) {
 			param++;
             fgets(puffer2,1000,f); chomp(puffer2);
             setSequence(puffer2);
+		} else if (strcmp(puffer,"PRECISION")==0) {
+			// optional
+			int32_t pr;
+			fscanf(f,"%i\n",&pr);
+			setprecision(pr);
+		} else if (strcmp(puffer,"C")==0) {
+			// optional
+			fscanf(f,"%le\n",&w1);
+			cwert=w1;
 		} else {
 			printf("Unknown parameter %s\n",puffer);
 			return 0;
@@ -1477,21 +3323,62 @@ Ljapunow::Ljapunow() {
     iter1d=100; iter1h=50; iter0h=50;
     INViter1d=1.0; INViter1d /= iter1d;
     x0=0.5;
+    cwert=0.0;
     seqlen=0; 
 	exps=0;
+	threads=std::thread::hardware_concurrency();
+	if (threads<1) threads=1;
+	for(int32_t i=0;i<ANZPHASES;i++) phasens[i]=0;
+	calcns=0;
+	statthreads=0;
+	kosten=NULL;
+	profiling=0;
+	perfok=0;
+	perffpraw=0;
+	for(int32_t i=0;i<ANZPERF;i++) perfcoloring[i]=0;
+	precision=PRECISION_DOUBLE;
+	quiet=0;
+	abbruch=0;
+	viewport=0;
+	vpexps=NULL;
+	vpkey=NULL;
+	vplenx=vpleny=0;
+	zustand=0;
+	zpx=zlambda=NULL;
+	zkey=NULL;
+	zschritte=-1;
+	zseqpos=0;
+	warmdiv=0;
+	gatediv=0;
+	gateschwelle=0;
+	gatestart();
+	zeilefertig=NULL;
+	zeilefertiglen=0;
+	fortschrittanz=0;
+	fortschritt=0;
+	aasamples=0;
+	aalambda=AALAMBDA;
+	aafarbe=AAFARBE;
+	aaidx=NULL;
+	aaexps=NULL;
+	aaanz=aalen=0;
+	aans=0;
+	skizzen=NULL;
+	skizzeok=0;
 };
 
 Ljapunow::~Ljapunow() {
 	if (exps) delete[] exps;
+	if (kosten) delete[] kosten;
+	setviewport(0);
+	setzustand(0);
+	if (zeilefertig) delete[] zeilefertig;
+	aafrei();
 	if (fkt) delete fkt;
     if (farbe) delete farbe;
 };
 
 int32_t Ljapunow::calc(const int32_t astart,const int32_t aende) {
-	double AB[16]; 
-    double px,abl1,abl2,tmp;
-	double lambda;
-    double xmin=9999999,xmax=-999999;
     int32_t start=astart;
     if (start<0) start=0;
     if (start>=leny) start=leny-1;
@@ -1499,143 +3386,1468 @@ int32_t Ljapunow::calc(const int32_t astart,const int32_t aende) {
     if (ende<0) ende=0;
     if (ende>=leny) ende=leny-1;
 
-	uint32_t offset;
-    Point32_t vx,vy;
-    vx.x=(lowerright.x-lowerleft.x)/lenx; vx.y=(lowerright.y-lowerleft.y)/lenx;
-    vy.x=(upperleft.x-lowerleft.x)/leny; vy.y=(upperleft.y-lowerleft.y)/leny;
+	TraceSpan span("calc");
+	aafrei();
+	skizzeok=0;
+	CalcJob job;
+	job.start=start;
+	job.ende=ende;
+    job.vx.x=(lowerright.x-lowerleft.x)/lenx; job.vx.y=(lowerright.y-lowerleft.y)/lenx;
+    job.vy.x=(upperleft.x-lowerleft.x)/leny; job.vy.y=(upperleft.y-lowerleft.y)/leny;
+	phasens[PHASE_SAVE]=0;
+	job.nextrow=start;
+	job.rowsdone=0;
+    job.t0=time(NULL);
+	job.bekannt=NULL;
+	job.fortsetzen=job.aufzeichnen=0;
+	job.probe=0;
+	int64_t tstart=nanosec();
+	perfok=0;
+	// whole images only, heatmap and profiling need the real calculation
+	const int32_t ganz=(start==0)&&(ende==leny-1)&&(!kosten)&&(!profiling);
+	const int32_t cachebar=(cachemax>0)&&(ganz);
+	int32_t len;
+	// warm start works on whole images and replaces viewport and state
+	const int32_t warm=(warmdiv>0)&&(ganz);
+	char* vkey=((viewport)&&(ganz)&&(!warm)) ? cachekey(len,CACHEKEY_ITER1) : NULL;
+	zeilenstart(start,ende,(warm) ? ((lenx+WARMTILE-1)/WARMTILE)*((leny+WARMTILE-1)/WARMTILE) : ende-start+1);
+	if ((cachebar)&&(cacheload()>0)) {
+		calcns=nanosec()-tstart;
+		statthreads=0;
+		phasens[PHASE_TRANSIENT]=phasens[PHASE_COMPUTE]=0;
+		if (vkey) viewportstore(vkey,job.vx,job.vy);
+		zeilenende(start,ende);
+		if ((aasamples>1)&&(ganz)) supersample(job.vx,job.vy);
+		return 1;
+	}
+	if (precision==PRECISION_TABLE) initSinTable();
+
+	// samples on the previous grid are copied instead of computed
+	uint8_t* bekannt=NULL;
+	int32_t anzbekannt=0;
+	if (vkey) {
+		bekannt=new uint8_t[lenx*leny];
+		int32_t genau=0;
+		anzbekannt=viewportreuse(vkey,job.vx,job.vy,bekannt,1,&genau);
+		if (!quiet) {
+			printf("viewport: %i of %i pixels reused (%.1lf%%)\n",anzbekannt,lenx*leny,100.0*anzbekannt/(lenx*leny));
+			if (genau<anzbekannt) printf("viewport: r of %i of them differs in the last bits, chaotic regions may differ from a fresh RUN\n",anzbekannt-genau);
+		}
+		job.bekannt=bekannt;
+	}
+
+	// state mode: if only iter1 grew, the pixels continue where they
+	// stopped. The state is recorded when every pixel is computed
+	char* skey=NULL;
+	if ((zustand)&&(ganz)&&(!warm)&&(anzbekannt==0)) {
+		skey=cachekey(len,CACHEKEY_GEOMETRY);
+		if (!zpx) {
+			zpx=new double[lenx*leny];
+			zlambda=new double[lenx*leny];
+		}
+		if ((zkey)&&(zschritte>=0)&&(zschritte<=(int32_t)iter1h)&&(strcmp(skey,zkey)==0)) {
+			job.fortsetzen=1;
+			if (!quiet) printf("continuing from %i of %i double steps\n",zschritte,iter1h);
+		}
+		job.aufzeichnen=1;
+	}
+
+	// rows (tiles in warm start mode) are handed out one at a time
+	// to the worker threads
+	void (Ljapunow::*arbeit)(CalcJob*,const int32_t)=&Ljapunow::calcRows;
+	int32_t anzeinheiten=ende-start+1;
+	if (warm) {
+		arbeit=&Ljapunow::calcTiles;
+		job.nextrow=0;
+		anzeinheiten=((lenx+WARMTILE-1)/WARMTILE)*((leny+WARMTILE-1)/WARMTILE);
+	}
+	int32_t anzt=minimumI(threads,anzeinheiten);
+	statthreads=anzt;
+	skizzen=new LambdaSketch[anzt];
+	if (anzt<=1) (this->*arbeit)(&job,0);
+	else {
+		std::thread* th[MAXTHREADS];
+		for(int32_t i=0;i<anzt;i++) th[i]=new std::thread(arbeit,this,&job,i);
+		for(int32_t i=0;i<anzt;i++) { th[i]->join(); delete th[i]; }
+	}
+	// the sketch describes whole images only
+	skizze.clear();
+	for(int32_t i=0;i<anzt;i++) skizze.merge(skizzen[i]);
+	skizzeok=(ganz)&&(!abbruch);
+	delete[] skizzen;
+	skizzen=NULL;
+
+	calcns=nanosec()-tstart;
+	CalcStats summe;
+	for(int32_t i=0;i<statthreads;i++) summe.add(threadstats[i]);
+	phasens[PHASE_TRANSIENT]=summe.ns[PHASE_TRANSIENT];
+	phasens[PHASE_COMPUTE]=summe.ns[PHASE_COMPUTE];
+	if (bekannt) delete[] bekannt;
+
+	if (skey) {
+		if (zkey) delete[] zkey;
+		zkey=skey;
+		zschritte=(abbruch) ? -1 : iter1h;
+		zseqpos=(seqlen>0) ? (2*(iter0h+iter1h)) % seqlen : 0;
+	}
+
+	// 0: cancelled, exps partially computed
+	if (abbruch) {
+		if (vkey) delete[] vkey;
+		return 0;
+	}
+	// tiles finish rows only together
+	if (warm) zeilenende(start,ende);
+	if (vkey) viewportstore(vkey,job.vx,job.vy);
+	if (cachebar) cachestore();
+	if ((aasamples>1)&&(ganz)) supersample(job.vx,job.vy);
+	return 1;
+};
 
-    time_t t0=time(NULL);
+void Ljapunow::zeilenstart(const int32_t start,const int32_t ende,const int32_t anz) {
+	// rows outside start..ende keep their exponents and count as done
+	if ((zeilefertig)&&(zeilefertiglen!=leny)) {
+		delete[] zeilefertig;
+		zeilefertig=NULL;
+	}
+	if (!zeilefertig) {
+		zeilefertig=new std::atomic<uint8_t>[leny];
+		zeilefertiglen=leny;
+		for(int32_t y=0;y<leny;y++) zeilefertig[y]=1;
+	}
+	for(int32_t y=start;y<=ende;y++) zeilefertig[y]=0;
+	fortschrittanz=anz;
+	fortschritt=0;
+}
+
+void Ljapunow::zeilenende(const int32_t start,const int32_t ende) {
+	for(int32_t y=start;y<=ende;y++) zeilefertig[y].store(1,std::memory_order_release);
+	fortschritt=(int32_t)fortschrittanz;
+}
+
+void Ljapunow::calcRows(CalcJob* job,const int32_t nr) {
+	// AB[symbol][lane]: disturbance parameter r of every lane
+	double AB[16][VECLEN];
+	double ABrow[2];
+	double* rowA=new double[lenx];
+	double* rowB=new double[lenx];
+	int32_t* xs=new int32_t[lenx];
+    double px[VECLEN],tmp[VECLEN],abl1[VECLEN],abl2[VECLEN];
+	double lambda[VECLEN];
+	CalcStats st;
+	int64_t skipped=0;
+	const int64_t cpu0=cpunanosec();
     const int32_t NOCH0=128;
-	int32_t noch=NOCH0;
+	PerfCounters pc;
+	uint64_t pw0[ANZPERF],pw1[ANZPERF],pw2[ANZPERF];
+	const int32_t perf=(profiling) ? pc.open(perffpraw) : 0;
+	if (perf>0) perfok=1;
+	LambdaSketch* sk=((skizzen)&&(!job->probe)) ? &skizzen[nr] : NULL;
+	for(int32_t l=0;l<VECLEN;l++) AB[2][l]=cwert;
+	tracetid=tracetidnext.fetch_add(1);
+	// the tier applies to calc only, geometry keeps the double path
+	trigtier=precision;
+
+	while (1) {
+		const int32_t y=job->nextrow.fetch_add(1);
+		if (y>job->ende) break;
+		if (abbruch) break;
+		TraceSpan span("row",y);
 
-	offset=start*lenx;
-	for(uint32_t y=start;y<=ende;y++) {
-		if (--noch==0) {
-			noch=NOCH0;
+		const int32_t done=job->rowsdone.fetch_add(1)+1;
+		if (((done % NOCH0)==0)&&(!quiet)) {
 			time_t b=time(NULL);
-			double d=difftime(b,t0);
-			d /= (y-start);
-			d *= (ende-y);
+			double d=difftime(b,job->t0);
+			d /= done;
+			d *= (job->ende-job->start+1-done);
 			printf("row %i --- %.0lf sec to go ---\n",y,d);
 		}
 
-		AB[0]=lowerleft.x+y*vy.x;
-		AB[1]=lowerleft.y+y*vy.y;
+		ABrow[0]=lowerleft.x+y*job->vy.x;
+		ABrow[1]=lowerleft.y+y*job->vy.y;
+		const uint32_t offset=y*lenx;
 
+		// r of every pixel along the row and the pixels to compute
+		// (accumulated, viewportreuse counts exact matches the same way)
+		int32_t anzx=0;
 		for(int32_t x=0;x<lenx;x++) {
-			px=x0;
-            int32_t seqpos=0;
+			rowA[x]=ABrow[0];
+			rowB[x]=ABrow[1];
+			ABrow[0]+=job->vx.x;
+			ABrow[1]+=job->vx.y;
+			if ((!job->bekannt)||(!job->bekannt[offset+x])) xs[anzx++]=x;
+			else if (sk) sk->add(exps[offset+x]);
+		}
+
+		// VECLEN pixels are iterated in lockstep, they all
+		// share the sequence position
+		for(int32_t k=0;k<anzx;k+=VECLEN) {
+			const int32_t n=minimumI(VECLEN,anzx-k);
+			const int32_t* xl=&xs[k];
+			for(int32_t l=0;l<n;l++) {
+				AB[0][l]=rowA[xl[l]];
+				AB[1][l]=rowB[xl[l]];
+				if (job->fortsetzen) {
+					px[l]=zpx[offset+xl[l]];
+					lambda[l]=zlambda[offset+xl[l]];
+				} else {
+					px[l]=x0;
+					lambda[l]=0.0;
+				}
+			}
+            int32_t seqpos=(job->fortsetzen) ? zseqpos : 0;
+			if (perf) pc.read(pw0);
+			int64_t t0=nanosec();
 
 			// initial iterations to settle a bit
-			for(int32_t i=0;i<iter0h;i++) {
-				fkt->eval(px,AB[sequence[seqpos]],tmp); 
+			for(int32_t i=(job->fortsetzen) ? iter0h : 0;i<iter0h;i++) {
+				fkt->evalvec(n,px,AB[sequence[seqpos]],tmp); 
 				SEQPOSINC(seqpos);
-                fkt->eval(tmp,AB[sequence[seqpos]],px); 
+                fkt->evalvec(n,tmp,AB[sequence[seqpos]],px); 
                 SEQPOSINC(seqpos);
 			} // i
+			int64_t t1=nanosec();
+			st.ns[PHASE_TRANSIENT] += (t1-t0);
+			if (perf) pc.read(pw1);
             
-            lambda = 0.0;
             // lyapunov value computing iterations
-			for(uint32_t i=0;i<iter1h;i++) {
-				fkt->eval(px,AB[sequence[seqpos]],tmp,abl1); 
+			for(uint32_t i=(job->fortsetzen) ? zschritte : 0;i<iter1h;i++) {
+				fkt->evalvec(n,px,AB[sequence[seqpos]],tmp,abl1); 
 				SEQPOSINC(seqpos);
-                fkt->eval(tmp,AB[sequence[seqpos]],px,abl2); 
+                fkt->evalvec(n,tmp,AB[sequence[seqpos]],px,abl2); 
                 SEQPOSINC(seqpos);
-				const double ab=fabs(abl1*abl2);
-				if (ab > 1E-300) lambda += log(ab);
+				for(int32_t l=0;l<n;l++) {
+					const double ab=fabs(abl1[l]*abl2[l]);
+					if (ab > 1E-300) lambda[l] += log(ab); else skipped++;
+				}
 			} // i
+			int64_t t2=nanosec();
+			st.ns[PHASE_COMPUTE] += (t2-t1);
+			if (perf) {
+				pc.read(pw2);
+				for(int32_t k=0;k<ANZPERF;k++) {
+					st.perf[PHASE_TRANSIENT][k] += pw1[k]-pw0[k];
+					st.perf[PHASE_COMPUTE][k] += pw2[k]-pw1[k];
+				}
+			}
 
-            exps[offset]=lambda * INViter1d;
-            offset++;
-			AB[0]+=vx.x;
-			AB[1]+=vx.y;
-		} // x
+			for(int32_t l=0;l<n;l++) {
+				exps[offset+xl[l]]=lambda[l] * INViter1d;
+				if ((px[l]!=px[l])||(lambda[l]!=lambda[l])) st.nanorbits++;
+				if (sk) sk->add(exps[offset+xl[l]]);
+			}
+			if (job->aufzeichnen) {
+				for(int32_t l=0;l<n;l++) {
+					zpx[offset+xl[l]]=px[l];
+					zlambda[offset+xl[l]]=lambda[l];
+				}
+			}
+			// per pixel cost at block resolution
+			if (kosten) {
+				const float kp=(float)(t2-t0)/n;
+				for(int32_t l=0;l<n;l++) kosten[offset+xl[l]]=kp;
+			}
+			st.pixels += n;
+		} // k
+		if (job->probe) continue;
+		if ((zeilefertig)&&(y<zeilefertiglen)) zeilefertig[y].store(1,std::memory_order_release);
+		fortschritt++;
 	} // y
 
-	return 1;
-};
-
-void Ljapunow::setfarbe(IntervalColoring* f) {
-	if (farbe) delete farbe;
-	farbe=f;
+	delete[] rowA;
+	delete[] rowB;
+	delete[] xs;
+
+	// eval and log calls follow from the iteration counts
+	const int64_t schritte1=(job->fortsetzen) ? iter1h-zschritte : iter1h;
+	const int64_t schritte0=(job->fortsetzen) ? 0 : iter0h;
+	st.evals=st.pixels*2*(schritte0+schritte1);
+	st.logs=st.pixels*schritte1-skipped;
+	st.skipped=skipped;
+	st.cpuns=cpunanosec()-cpu0;
+	threadstats[nr]=st;
+	tracetid=0;
+	trigtier=PRECISION_DOUBLE;
+}
+
+void hilbertPunkt(const int32_t n,const int32_t d,int32_t& x,int32_t& y) {
+	// d-th point of the Hilbert curve through n x n cells
+	int32_t t=d;
+	x=y=0;
+	for(int32_t s=1;s<n;s*=2) {
+		const int32_t rx=1 & (t/2);
+		const int32_t ry=1 & (t ^ rx);
+		if (ry==0) {
+			if (rx==1) { x=s-1-x; y=s-1-y; }
+			const int32_t h=x; x=y; y=h;
+		}
+		x += s*rx;
+		y += s*ry;
+		t /= 4;
+	}
 }
 
-void Ljapunow::setiter(const int32_t i0,const int32_t i1) {
-	iter0=i0; iter0h=(i0 >> 1);
-	iter1=i1; iter1h=(i1 >> 1); 
-	iter1d=(iter1h << 1);
-	INViter1d=1.0; INViter1d /= iter1d;
-}
+void Ljapunow::calcTiles(CalcJob* job,const int32_t nr) {
+	// warm start: VECLEN consecutive points of a Hilbert curve form a
+	// block. A block starts from the last orbit points and sequence
+	// position of the block before it with a shortened transient. The
+	// first block of a tile and blocks after an exponent changed its
+	// sign start cold from x0
+	const int32_t T=WARMTILE;
+	const int32_t anztx=(lenx+T-1)/T,anzty=(leny+T-1)/T;
+	int32_t hx[T*T],hy[T*T];
+	for(int32_t d=0;d<(T*T);d++) hilbertPunkt(T,d,hx[d],hy[d]);
+	double tA[T*T],tB[T*T];
+	double AB[16][VECLEN];
+	double px[VECLEN],tmp[VECLEN],abl1[VECLEN],abl2[VECLEN];
+	double lambda[VECLEN],quelle[VECLEN],quelleexp[VECLEN];
+	int32_t idx[VECLEN];
+	const int32_t iterw=((iter0h/warmdiv)>WARMMIN) ? iter0h/warmdiv : minimumI(WARMMIN,iter0h);
+	LambdaSketch* sk=(skizzen) ? &skizzen[nr] : NULL;
+	CalcStats st;
+	int64_t skipped=0;
+	const int64_t cpu0=cpunanosec();
+	for(int32_t l=0;l<VECLEN;l++) AB[2][l]=cwert;
+	tracetid=tracetidnext.fetch_add(1);
+	trigtier=precision;
 
-void Ljapunow::savedescr(const char* fn) {
-	FILE *fff=fopen(fn,"wt");
-	char tmp2[1024],tmp3[1024];
+	while (1) {
+		const int32_t t=job->nextrow.fetch_add(1);
+		if (t>=(anztx*anzty)) break;
+		if (abbruch) break;
+		TraceSpan span("tile",t);
+		const int32_t xt=(t % anztx)*T,yt=(t / anztx)*T;
+
+		// r along the rows accumulated as in calcRows
+		for(int32_t yy=0;yy<T;yy++) {
+			const int32_t y=minimumI(yt+yy,leny-1);
+			double ABrow[2];
+			ABrow[0]=lowerleft.x+y*job->vy.x;
+			ABrow[1]=lowerleft.y+y*job->vy.y;
+			for(int32_t x=0;x<minimumI(xt+T,lenx);x++) {
+				if (x>=xt) { tA[yy*T+x-xt]=ABrow[0]; tB[yy*T+x-xt]=ABrow[1]; }
+				ABrow[0]+=job->vx.x;
+				ABrow[1]+=job->vx.y;
+			}
+		}
 
-	fprintf(fff,"x0=%lf, %i initial and %i computing iterations\n",x0,iter0,iter1);
-	fprintf(fff,"Trajectory function f(x)=%s\n",fkt->fktStr(tmp2));
-	fprintf(fff,"Computing function g(x)=%s\n",fkt->ablStr(tmp2));
-	fprintf(fff,"Sequence %s. Center (%.2lf/%.2lf) size=%.10lf\n",
-		getSequence(tmp3),
-		(lowerleft.x+lowerright.x)*0.5,
-		0.5*(lowerleft.y+upperleft.y),
-		sqrt( maximumD(
-			( (lowerleft.x-lowerright.x)*(lowerleft.x-lowerright.x) + (lowerleft.y-lowerright.y)*(lowerleft.y-lowerright.y) ),
-			( (lowerleft.x-upperleft.x)*(lowerleft.x-upperleft.x) + (lowerleft.y-upperleft.y)*(lowerleft.y-upperleft.y) )
-		) )
-	);
+		int32_t warm=0,nquelle=0,seqquelle=0;
+		int32_t d=0;
+		while (d<(T*T)) {
+			int32_t n=0;
+			while ((d<(T*T))&&(n<VECLEN)) {
+				const int32_t x=xt+hx[d],y=yt+hy[d];
+				const int32_t k=hy[d]*T+hx[d];
+				d++;
+				if ((x>=lenx)||(y>=leny)) continue;
+				AB[0][n]=tA[k];
+				AB[1][n]=tB[k];
+				idx[n]=y*lenx+x;
+				n++;
+			}
+			if (n==0) break;
 
-	if (farbe->id == ID_FAERBUNG_INTERVALL) {
-		IntervalColoring* previ=(IntervalColoring*)farbe;
-		fprintf(fff,"Coloring with linear RGB value interpolation in several intervals\nLyapunov exponents less than %lf: RGB(%i,%i,%i)\n",previ->ints[0]->gl,previ->lr,previ->lg,previ->lb);
-		for(int32_t i=0;i<previ->intanz;i++) {
-			fprintf(fff,"in [%.2lf..%.2lf] (%i,%i,%i)..(%i,%i,%i)\n",previ->ints[i]->gl,previ->ints[i]->gr,
-			previ->ints[i]->lr,previ->ints[i]->lg,previ->ints[i]->lb,previ->ints[i]->rr,previ->ints[i]->rg,previ->ints[i]->rb);
+			int32_t seqpos=0,transient=iter0h;
+			for(int32_t l=0;l<n;l++) {
+				px[l]=(warm) ? quelle[l % nquelle] : x0;
+				lambda[l]=0.0;
+			}
+			if (warm) {
+				seqpos=seqquelle;
+				transient=iterw;
+			}
+			int64_t t0=nanosec();
+			for(int32_t i=0;i<transient;i++) {
+				fkt->evalvec(n,px,AB[sequence[seqpos]],tmp); 
+				SEQPOSINC(seqpos);
+                fkt->evalvec(n,tmp,AB[sequence[seqpos]],px); 
+                SEQPOSINC(seqpos);
+			}
+			int64_t t1=nanosec();
+			st.ns[PHASE_TRANSIENT] += (t1-t0);
+			for(uint32_t i=0;i<iter1h;i++) {
+				fkt->evalvec(n,px,AB[sequence[seqpos]],tmp,abl1); 
+				SEQPOSINC(seqpos);
+                fkt->evalvec(n,tmp,AB[sequence[seqpos]],px,abl2); 
+                SEQPOSINC(seqpos);
+				for(int32_t l=0;l<n;l++) {
+					const double ab=fabs(abl1[l]*abl2[l]);
+					if (ab > 1E-300) lambda[l] += log(ab); else skipped++;
+				}
+			}
+			int64_t t2=nanosec();
+			st.ns[PHASE_COMPUTE] += (t2-t1);
+
+			// the next block starts warm unless the regime changed
+			int32_t kalt=0;
+			for(int32_t l=0;l<n;l++) {
+				const double e=lambda[l] * INViter1d;
+				exps[idx[l]]=e;
+				if (sk) sk->add(e);
+				if ((px[l]!=px[l])||(lambda[l]!=lambda[l])) { st.nanorbits++; kalt=1; }
+				if ((warm)&&((e<0)!=(quelleexp[l % nquelle]<0))) kalt=1;
+				quelle[l]=px[l];
+				quelleexp[l]=e;
+			}
+			if (kosten) {
+				const float kp=(float)(t2-t0)/n;
+				for(int32_t l=0;l<n;l++) kosten[idx[l]]=kp;
+			}
+			st.pixels += n;
+			st.evals += (int64_t)n*2*(transient+iter1h);
+			st.logs += (int64_t)n*iter1h;
+			nquelle=n;
+			seqquelle=seqpos;
+			warm=(kalt) ? 0 : 1;
+		} // d
+		fortschritt++;
+	} // t
+
+	st.logs -= skipped;
+	st.skipped=skipped;
+	st.cpuns=cpunanosec()-cpu0;
+	threadstats[nr]=st;
+	tracetid=0;
+	trigtier=PRECISION_DOUBLE;
+}
+
+void aaJitter(const int32_t x,const int32_t y,const int32_t k,double& dx,double& dy) {
+	// sample k of pixel (x|y): points of the R2 sequence shifted by a
+	// hash of the pixel, in [-0.5..0.5) of a pixel, the same every run
+	uint64_t h=((uint64_t)(uint32_t)x << 32) ^ (uint32_t)y;
+	h ^= h >> 33; h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	const double u=(h >> 11)*(1.0/9007199254740992.0);
+	const double v=(h & 0x1FFFFF)*(1.0/2097152.0);
+	dx=u+k*0.7548776662466927; dx -= floor(dx);
+	dy=v+k*0.5698402909980532; dy -= floor(dy);
+	dx -= 0.5;
+	dy -= 0.5;
+}
+
+void Ljapunow::setsupersample(const int32_t n,const double l,const int32_t f) {
+	aasamples=(n>MAXAASAMPLES) ? MAXAASAMPLES : n;
+	if (aasamples<2) aasamples=0;
+	aalambda=l;
+	aafarbe=f;
+	aafrei();
+}
+
+void Ljapunow::aafrei(void) {
+	if (aaidx) delete[] aaidx;
+	if (aaexps) delete[] aaexps;
+	aaidx=NULL;
+	aaexps=NULL;
+	aaanz=aalen=0;
+}
+
+void Ljapunow::supersample(const Point32_t& vx,const Point32_t& vy) {
+	// pixels that differ from a neighbour in color or exponent are
+	// computed again at aasamples-1 jittered positions inside the pixel.
+	// The colors are averaged when the bitmap is created
+	TraceSpan span("supersample");
+	int64_t t0=nanosec();
+	const int32_t anz=lenx*leny,extra=aasamples-1;
+	int32_t* rgb=new int32_t[anz];
+	int32_t r,g,b;
+	{
+		// LOADCOLOR of the menu may replace farbe during an ASYNC RUN
+		std::lock_guard<std::mutex> lock(menujob.m);
+		for(int32_t i=0;i<anz;i++) {
+			if (farbe) farbe->farbe(exps[i],r,g,b); else r=g=b=0;
+			rgb[i]=(r << 16) | (g << 8) | b;
 		}
-		fprintf(fff,"greater than %.2lf: (%i,%i,%i)\n",previ->ints[previ->intanz-1]->gr,previ->rr,previ->rg,previ->rb);
 	}
-	fclose(fff);
-}
+	aaidx=new int32_t[anz];
+	aaanz=0;
+	for(int32_t y=0;y<leny;y++) for(int32_t x=0;x<lenx;x++) {
+		const int32_t i=y*lenx+x;
+		int32_t verschieden=0;
+		const int32_t nb[4]={ (x>0) ? i-1 : -1,(x<(lenx-1)) ? i+1 : -1,(y>0) ? i-lenx : -1,(y<(leny-1)) ? i+lenx : -1 };
+		for(int32_t k=0;(k<4)&&(!verschieden);k++) {
+			const int32_t j=nb[k];
+			if (j<0) continue;
+			const double e0=exps[i],e1=exps[j];
+			if ((e0!=e0)!=(e1!=e1)) verschieden=1;
+			else if (fabs(e0-e1)>aalambda) verschieden=1;
+			for(int32_t c=0;c<24;c+=8) {
+				const int32_t d=((rgb[i] >> c) & 0xFF)-((rgb[j] >> c) & 0xFF);
+				if ((d>aafarbe)||(-d>aafarbe)) verschieden=1;
+			}
+		}
+		aaidx[i]=(verschieden) ? (aaanz++)*extra : -1;
+	}
+	delete[] rgb;
+
+	SampleJob job;
+	job.anz=aaanz*extra;
+	job.A=new double[job.anz];
+	job.B=new double[job.anz];
+	aaexps=job.erg=new double[job.anz];
+	aalen=anz;
+	for(int32_t y=0;y<leny;y++) for(int32_t x=0;x<lenx;x++) {
+		const int32_t i=aaidx[y*lenx+x];
+		if (i<0) continue;
+		for(int32_t k=0;k<extra;k++) {
+			double dx,dy;
+			aaJitter(x,y,k+1,dx,dy);
+			job.A[i+k]=lowerleft.x+(x+dx)*vx.x+(y+dy)*vy.x;
+			job.B[i+k]=lowerleft.y+(x+dx)*vx.y+(y+dy)*vy.y;
+		}
+	}
+	job.next=0;
+	const int32_t anzt=minimumI(threads,(job.anz+VECLEN-1)/VECLEN);
+	if (anzt<=1) calcSamples(&job,0);
+	else {
+		std::thread* th[MAXTHREADS];
+		for(int32_t t=0;t<anzt;t++) th[t]=new std::thread(&Ljapunow::calcSamples,this,&job,t);
+		for(int32_t t=0;t<anzt;t++) { th[t]->join(); delete th[t]; }
+	}
+	delete[] job.A;
+	delete[] job.B;
+	aans=nanosec()-t0;
+	if (!quiet) printf("supersampling: %i of %i pixels refined, %.3lf samples per pixel, %.3lf sec\n",
+		aaanz,anz,1.0+(double)aaanz*extra/anz,aans*1E-9);
+}
+
+void Ljapunow::calcSamples(SampleJob* job,const int32_t nr) {
+	// the iteration of calcRows on arbitrary points
+	double AB[16][VECLEN];
+	double px[VECLEN],tmp[VECLEN],abl1[VECLEN],abl2[VECLEN];
+	double lambda[VECLEN];
+	for(int32_t l=0;l<VECLEN;l++) AB[2][l]=cwert;
+	tracetid=tracetidnext.fetch_add(1);
+	trigtier=precision;
 
-int32_t Ljapunow::iterStart(void) {
-	if ((!fkt) || (!farbe) ) return 0;
-	if (fkt->iterStart()<=0) return 0;
-	return 1;
-}
+	while (1) {
+		if (abbruch) break;
+		const int32_t k=job->next.fetch_add(VECLEN);
+		if (k>=job->anz) break;
+		const int32_t n=minimumI(VECLEN,job->anz-k);
+		for(int32_t l=0;l<n;l++) {
+			AB[0][l]=job->A[k+l];
+			AB[1][l]=job->B[k+l];
+			px[l]=x0;
+			lambda[l]=0.0;
+		}
+		int32_t seqpos=0;
+		for(int32_t i=0;i<iter0h;i++) {
+			fkt->evalvec(n,px,AB[sequence[seqpos]],tmp);
+			SEQPOSINC(seqpos);
+			fkt->evalvec(n,tmp,AB[sequence[seqpos]],px);
+			SEQPOSINC(seqpos);
+		}
+		for(int32_t i=0;i<iter1h;i++) {
+			fkt->evalvec(n,px,AB[sequence[seqpos]],tmp,abl1);
+			SEQPOSINC(seqpos);
+			fkt->evalvec(n,tmp,AB[sequence[seqpos]],px,abl2);
+			SEQPOSINC(seqpos);
+			for(int32_t l=0;l<n;l++) {
+				const double ab=fabs(abl1[l]*abl2[l]);
+				if (ab > 1E-300) lambda[l] += log(ab);
+			}
+		}
+		for(int32_t l=0;l<n;l++) job->erg[k+l]=lambda[l] * INViter1d;
+	}
+	tracetid=0;
+	trigtier=PRECISION_DOUBLE;
+}
+
+void autoRampe(const int32_t stufen[][3],const int32_t anz,const double t,int32_t& r,int32_t& g,int32_t& b) {
+	// color at t in [0..1] along anz equally spaced stops
+	double p=t*(anz-1);
+	if (p<0) p=0;
+	if (p>(anz-1)) p=anz-1;
+	int32_t i=(int32_t)p;
+	if (i>=(anz-1)) i=anz-2;
+	const double f=p-i;
+	r=(int32_t)(stufen[i][0]+f*(stufen[i+1][0]-stufen[i][0])+0.5);
+	g=(int32_t)(stufen[i][1]+f*(stufen[i+1][1]-stufen[i][1])+0.5);
+	b=(int32_t)(stufen[i][2]+f*(stufen[i+1][2]-stufen[i][2])+0.5);
+}
+
+int32_t Ljapunow::autocolor(const int32_t anzint) {
+	// n intervals holding equal shares of the pixels between the
+	// quantiles AUTORAND and 1-AUTORAND of the sketch of the last calc.
+	// 0 is always a bound: order and chaos use their own ramp
+	if (!exps) return -1;
+	const int32_t n=(anzint<2) ? 2 : ((anzint>(MAXINTANZ-1)) ? MAXINTANZ-1 : anzint);
+	if (!skizzeok) {
+		// exponents loaded or cached: one pass instead
+		printf("no sketch of the last calc, reading the exponents\n");
+		skizze.clear();
+		for(int32_t i=0;i<(lenx*leny);i++) skizze.add(exps[i]);
+		skizzeok=1;
+	}
+	if (skizze.anz<=0) return -1;
+	const double QS[]={ 0.01,0.05,0.25,0.5,0.75,0.95,0.99 };
+	printf("exponents %lli (NaN %lli) from %.4le to %.4le\nquantiles",
+		(long long)skizze.anz,(long long)skizze.nan,skizze.minw,skizze.maxw);
+	for(int32_t i=0;i<(int32_t)(sizeof(QS)/sizeof(QS[0]));i++) printf(" %g%%: %.4lf",100*QS[i],skizze.quantil(QS[i]));
+	printf("\n");
+
+	double grenzen[MAXINTANZ+1];
+	int32_t anzg=0;
+	for(int32_t i=0;i<=n;i++) {
+		const double w=skizze.quantil(AUTORAND+i*(1.0-2*AUTORAND)/n);
+		if ((anzg>0)&&(w<=grenzen[anzg-1])) continue;
+		if ((anzg>0)&&(grenzen[anzg-1]<0)&&(w>0)) grenzen[anzg++]=0;
+		grenzen[anzg++]=w;
+	}
+	if (anzg<2) {
+		printf("Exponents too uniform\n");
+		return 0;
+	}
 
-int32_t Ljapunow::iterWeiter(void) {
-	if ((!fkt) || (!farbe) ) return 0;
-	if (fkt->iterWeiter()<=0) return 0;
+	int32_t anzneg=0;
+	for(int32_t i=1;i<anzg;i++) if (grenzen[i]<=0) anzneg++;
+	const int32_t anzpos=anzg-1-anzneg;
+	const int32_t NNEG=sizeof(AUTONEG)/sizeof(AUTONEG[0]),NPOS=sizeof(AUTOPOS)/sizeof(AUTOPOS[0]);
+	IntervalColoring* f=new IntervalColoring;
+	int32_t r,g,b;
+	for(int32_t i=0;i<(anzg-1);i++) {
+		ColIntv* c=new ColIntv;
+		c->setgrenzel(grenzen[i]);
+		c->setgrenzer(grenzen[i+1]);
+		if (i<anzneg) {
+			autoRampe(AUTONEG,NNEG,(double)i/anzneg,r,g,b);
+			c->setfarbel(r,g,b);
+			if (i==0) f->setfarbel(r,g,b);
+			autoRampe(AUTONEG,NNEG,(double)(i+1)/anzneg,r,g,b);
+			c->setfarber(r,g,b);
+		} else {
+			autoRampe(AUTOPOS,NPOS,(double)(i-anzneg)/anzpos,r,g,b);
+			c->setfarbel(r,g,b);
+			if (i==0) f->setfarbel(r,g,b);
+			autoRampe(AUTOPOS,NPOS,(double)(i+1-anzneg)/anzpos,r,g,b);
+			c->setfarber(r,g,b);
+		}
+		f->Addintervall(c);
+		printf("  [%.4lf..%.4lf)\n",grenzen[i],grenzen[i+1]);
+	}
+	f->setfarber(r,g,b);
+	setfarbe(f);
 	return 1;
 }
 
-void Ljapunow::setlen(const int32_t xl,const int32_t yl) {
-	if (exps) delete[] exps;
-	lenx=((xl >> 2) << 2);
-	leny=((yl >> 2) << 2);
-    exps=new double[lenx*leny];
+void Ljapunow::checkwarm(void) {
+	// cold against warm start on the current image. exps are preserved
+	if ((!exps)||(!farbe)||(seqlen<=0)) { printf("Nothing to compute\n"); return; }
+	if (warmdiv<=0) { printf("Warm start is off\n"); return; }
+
+	const int32_t anz=lenx*leny;
+	double* sicexps=new double[anz];
+	double* ref=new double[anz];
+	memcpy(sicexps,exps,anz*sizeof(double));
+	const int32_t sicwarm=warmdiv;
+
+	warmdiv=0;
+	int64_t t0=nanosec();
+	calc(0,leny-1);
+	const double tkalt=(nanosec()-t0)*1E-9;
+	memcpy(ref,exps,anz*sizeof(double));
+	warmdiv=sicwarm;
+	t0=nanosec();
+	calc(0,leny-1);
+	const double twarm=(nanosec()-t0)*1E-9;
+
+	double maxabw=0,summe=0;
+	int32_t anzfarbe=0,anzabw=0;
+	for(int32_t i=0;i<anz;i++) {
+		int32_t r1=0,g1=0,b1=0,r2=0,g2=0,b2=0;
+		farbe->farbe(exps[i],r1,g1,b1);
+		farbe->farbe(ref[i],r2,g2,b2);
+		if ((r1!=r2)||(g1!=g2)||(b1!=b2)) anzfarbe++;
+		const double d=fabs(exps[i]-ref[i]);
+		if (d!=d) continue;
+		if (d>maxabw) maxabw=d;
+		summe += d;
+		anzabw++;
+	}
+	printf("cold %.3lf sec  warm %.3lf sec  (factor %.2lf)\n",tkalt,twarm,(twarm>0) ? tkalt/twarm : 0);
+	printf("drift: max %le  mean %le  color changed %.3lf%%\n",maxabw,(anzabw>0) ? summe/anzabw : 0,100.0*anzfarbe/anz);
+
+	memcpy(exps,sicexps,anz*sizeof(double));
+	delete[] sicexps;
+	delete[] ref;
+}
+
+double Ljapunow::estimate(int64_t& mem,int64_t& ausgabe,const int32_t ausgeben) {
+	// predicted seconds of a whole-image calc from ESTZEILEN rows of
+	// ESTBLOECKE blocks each, computed by calcRows with the current
+	// function, sequence, iterations, tier and instruction set and
+	// scaled by pixels, threads and the fast paths that apply (cache,
+	// viewport, state, warm start). mem: bytes of the image buffers,
+	// ausgabe: bytes of the saved files. -1: nothing to estimate
+	mem=ausgabe=0;
+	if ((!fkt)||(!farbe)||(!exps)||(seqlen<=0)) return -1;
+	const int64_t anz=(int64_t)lenx*leny;
+
+	mem=anz*(sizeof(double)+3)+(int64_t)threads*3*lenx*sizeof(double);
+	if (kosten) mem += anz*sizeof(float);
+	if (viewport) mem += anz*sizeof(double);
+	if (zustand) mem += 2*anz*sizeof(double);
+	ausgabe=2*sizeof(int32_t)+anz*sizeof(double)+BMPKOPF+3*anz;
+	FILE *f=tmpfile();
+	if (f) { savepar(f); ausgabe += ftell(f); fclose(f); }
+	if (zustand) ausgabe += 2*anz*sizeof(double)+64;
+
+	// the sample: ESTBLOECKE blocks spread over each of ESTZEILEN
+	// evenly spaced rows, everything else is marked known
+	CalcJob job;
+	job.start=0;
+	job.ende=leny-1;
+    job.vx.x=(lowerright.x-lowerleft.x)/lenx; job.vx.y=(lowerright.y-lowerleft.y)/lenx;
+    job.vy.x=(upperleft.x-lowerleft.x)/leny; job.vy.y=(upperleft.y-lowerleft.y)/leny;
+	job.nextrow=0;
+	job.rowsdone=0;
+	job.t0=time(NULL);
+	job.fortsetzen=job.aufzeichnen=0;
+	job.probe=1;
+	uint8_t* bekannt=new uint8_t[anz];
+	memset(bekannt,1,anz);
+	const int32_t anzz=minimumI(ESTZEILEN,leny);
+	const int32_t anzb=minimumI(ESTBLOECKE,(lenx+VECLEN-1)/VECLEN);
+	int32_t anzp=0;
+	for(int32_t k=0;k<anzz;k++) for(int32_t b=0;b<anzb;b++) {
+		const int32_t y=(2*k+1)*leny/(2*anzz);
+		const int32_t x0=minimumI(b*lenx/anzb,lenx-VECLEN > 0 ? lenx-VECLEN : 0);
+		for(int32_t x=x0;x<minimumI(x0+VECLEN,lenx);x++) {
+			if (bekannt[y*lenx+x]) anzp++;
+			bekannt[y*lenx+x]=0;
+		}
+	}
+	job.bekannt=bekannt;
+	// exps, heatmap and thread stats of the sample are put back
+	double* sicexps=new double[anzp];
+	float* sickosten=new float[anzp];
+	int32_t n=0;
+	for(int64_t i=0;i<anz;i++) if (!bekannt[i]) {
+		sicexps[n]=exps[i];
+		if (kosten) sickosten[n]=kosten[i];
+		n++;
+	}
+	const CalcStats sicst=threadstats[0];
+	const int32_t sicquiet=quiet;
+	quiet=1;
+	if (precision==PRECISION_TABLE) initSinTable();
+	int64_t t0=nanosec();
+	calcRows(&job,0);
+	const int64_t nsprobe=nanosec()-t0;
+	const CalcStats st=threadstats[0];
+	threadstats[0]=sicst;
+	quiet=sicquiet;
+	n=0;
+	for(int64_t i=0;i<anz;i++) if (!bekannt[i]) {
+		exps[i]=sicexps[n];
+		if (kosten) kosten[i]=sickosten[n];
+		n++;
+	}
+	delete[] sicexps;
+	delete[] sickosten;
+	const double nspixel=(st.pixels>0) ? (double)(st.ns[PHASE_TRANSIENT]+st.ns[PHASE_COMPUTE])/st.pixels : 0;
+
+	// fast paths of calc
+	int64_t pixel=anz;
+	double faktor=1.0;
+	const char* weg="";
+	int32_t len;
+	const int32_t warm=(warmdiv>0);
+	char* key=cachekey(len);
+	if (key) {
+		char fc[1200];
+		sprintf(fc,"%s/%016llx.ljc",cachedir,(unsigned long long)fnv1a(key,len,0));
+		FILE *fe=((cachemax>0)&&(!kosten)&&(!profiling)) ? fopen(fc,"rb") : NULL;
+		if (fe) { fclose(fe); pixel=0; weg="cache hit"; }
+		delete[] key;
+	}
+	if ((pixel>0)&&(viewport)&&(!warm)) {
+		char* vkey=cachekey(len,CACHEKEY_ITER1);
+		const int32_t r=viewportreuse(vkey,job.vx,job.vy,bekannt,0);
+		if (r>0) { pixel -= r; weg="viewport"; }
+		delete[] vkey;
+	}
+	if ((pixel==anz)&&(zustand)&&(!warm)&&(zkey)&&(zschritte>=0)&&(zschritte<=(int32_t)iter1h)) {
+		char* skey=cachekey(len,CACHEKEY_GEOMETRY);
+		if (strcmp(skey,zkey)==0) {
+			faktor=(double)(iter1h-zschritte)/(iter0h+iter1h);
+			weg="state";
+		}
+		delete[] skey;
+	}
+	if ((pixel>0)&&(warm)&&((iter0h+iter1h)>0)) {
+		const int32_t iterw=((iter0h/warmdiv)>WARMMIN) ? iter0h/warmdiv : minimumI(WARMMIN,iter0h);
+		faktor=(double)(iterw+iter1h)/(iter0h+iter1h);
+		weg="warm start";
+	}
+	delete[] bekannt;
+
+	// rows are the unit of work between threads
+	int32_t anzt=minimumI(threads,leny);
+	const int32_t cpus=std::thread::hardware_concurrency();
+	if ((cpus>0)&&(anzt>cpus)) anzt=cpus;
+	if (anzt<1) anzt=1;
+	const double sek=pixel*faktor*nspixel*1E-9/anzt;
+
+	if (ausgeben) {
+		printf("sample: %lli pixels in %.3lf sec, %.0lf ns per pixel (%s, %s)\n",
+			(long long)st.pixels,nsprobe*1E-9,nspixel,PRECISIONNAMES[precision],ISANAMES[isa]);
+		printf("estimate: %.1lf sec with %i threads",sek,anzt);
+		if (weg[0]) printf(" (%s)",weg);
+		printf("\nmemory %.1lf MB, files %.1lf MB\n",mem/1048576.0,ausgabe/1048576.0);
+	}
+	return sek;
 }
 
-void Ljapunow::saveexp(char *fn) {
-	FILE *f=fopen(fn,"wb");
-    fwrite(&lenx,sizeof(lenx),1,f);
-    fwrite(&leny,sizeof(leny),1,f);
-    fwrite(exps,sizeof(double),lenx*leny,f);
-    fclose(f);
+int32_t uint32Cmp(const void* a,const void* b) {
+	const uint32_t wa=*(const uint32_t*)a;
+	const uint32_t wb=*(const uint32_t*)b;
+	return (wa<wb) ? -1 : ((wa>wb) ? 1 : 0);
 }
 
-int32_t Ljapunow::loadexp(char *fn) {
-    FILE *f=fopen(fn,"rb");
-	if (!f) return 0;
+void Ljapunow::setgate(const double schwelle,const int32_t div) {
+	if ((schwelle<=0)||(div<=1)) {
+		gatediv=0;
+		printf("walk gating off\n");
+		return;
+	}
+	gateschwelle=schwelle;
+	gatediv=div;
+	printf("walk gating: thumbnail 1/%i, threshold %.4lf\n",gatediv,gateschwelle);
+}
+
+double Ljapunow::gatescore(double& entropie,double& kanten,double& flach) {
+	// statistics of the colored image in exps: entropy of the colors
+	// (normalized by log2 of the pixel count), share of neighbouring
+	// pixel pairs forming an edge, share of pixels without an edge to
+	// any neighbour. Uniform images score 0 by flatness, noise by edges
+	const int32_t anz=lenx*leny;
+	int32_t* rgb=new int32_t[anz];
+	uint32_t* sortiert=new uint32_t[anz];
+	for(int32_t i=0;i<anz;i++) {
+		int32_t r=0,g=0,b=0;
+		farbe->farbe(exps[i],r,g,b);
+		rgb[i]=(r << 16) | (g << 8) | b;
+		sortiert[i]=rgb[i];
+	}
+	qsort(sortiert,anz,sizeof(uint32_t),uint32Cmp);
+	entropie=0;
+	for(int32_t i=0;i<anz;) {
+		int32_t j=i+1;
+		while ((j<anz)&&(sortiert[j]==sortiert[i])) j++;
+		const double p=(double)(j-i)/anz;
+		entropie -= p*log2(p);
+		i=j;
+	}
+	if (anz>1) entropie /= log2((double)anz);
+
+	#define GATEKANTEN(A,B) \
+		( \
+			abs( (((A) >> 16) & 255) - (((B) >> 16) & 255) ) + \
+			abs( (((A) >> 8) & 255) - (((B) >> 8) & 255) ) + \
+			abs( ((A) & 255) - ((B) & 255) ) \
+		> GATEKANTE)
+
+	int32_t anzpaare=0,anzkanten=0,anzflach=0;
+	for(int32_t y=0;y<leny;y++) for(int32_t x=0;x<lenx;x++) {
+		const int32_t i=y*lenx+x;
+		int32_t k=0;
+		if (x>0) k += GATEKANTEN(rgb[i],rgb[i-1]);
+		if (x<(lenx-1)) { 
+			const int32_t e=GATEKANTEN(rgb[i],rgb[i+1]);
+			k += e;
+			anzkanten += e;
+			anzpaare++;
+		}
+		if (y>0) k += GATEKANTEN(rgb[i],rgb[i-lenx]);
+		if (y<(leny-1)) {
+			const int32_t e=GATEKANTEN(rgb[i],rgb[i+lenx]);
+			k += e;
+			anzkanten += e;
+			anzpaare++;
+		}
+		if (k==0) anzflach++;
+	}
+	kanten=(anzpaare>0) ? (double)anzkanten/anzpaare : 0;
+	flach=(double)anzflach/anz;
+
+	delete[] rgb;
+	delete[] sortiert;
+	return entropie*(1.0-flach)*(1.0-kanten);
+}
+
+int32_t Ljapunow::walkcalc(void) {
+	// computes one walk candidate. With gating on a thumbnail is computed
+	// and scored first, the full image only if the score reaches the
+	// threshold. Returns 0 if the candidate was dropped or cancelled
+	gateanz++;
+	const int64_t evalsvoll=(int64_t)lenx*leny*2*(iter0h+iter1h);
+	if (gatediv<=0) {
+		int64_t t0=nanosec();
+		const int32_t ok=calc(0,leny-1);
+		gatefullns += nanosec()-t0;
+		gatefullevals += evalsvoll;
+		gatepromoted++;
+		return ok;
+	}
 
-    int32_t wx,wy;
-    fread(&wx,sizeof(lenx),1,f);
-	fread(&wy,sizeof(leny),1,f);
-	if ((wx!=lenx)||(wy!=leny)) {
-		fclose(f);
+	const int32_t sicx=lenx,sicy=leny,sici0=iter0,sici1=iter1;
+	const int32_t sicvp=viewport,sicquiet=quiet,sicaa=aasamples;
+	int32_t tx=lenx/gatediv,ty=leny/gatediv;
+	if (tx<GATEMINLEN) tx=GATEMINLEN;
+	if (ty<GATEMINLEN) ty=GATEMINLEN;
+	// the thumbnail must not replace the remembered viewport image
+	viewport=0;
+	quiet=1;
+	aasamples=0;
+	setlen(tx,ty);
+	setiter(
+		(iter0/gatediv)>2 ? iter0/gatediv : 2,
+		(iter1/gatediv)>2 ? iter1/gatediv : 2
+	);
+	int64_t t0=nanosec();
+	int32_t ok=calc(0,leny-1);
+	gatethumbns += nanosec()-t0;
+	gatethumbevals += (int64_t)lenx*leny*2*(iter0h+iter1h);
+	double entropie=0,kanten=0,flach=0,score=0;
+	if (ok>0) score=gatescore(entropie,kanten,flach);
+	setlen(sicx,sicy);
+	setiter(sici0,sici1);
+	viewport=sicvp;
+	quiet=sicquiet;
+	aasamples=sicaa;
+
+	printf("[gate %.4lf entropy %.3lf edges %.3lf flat %.3lf] ",score,entropie,kanten,flach);
+	if ((ok<=0)||(score<gateschwelle)) {
+		printf("dropped\n");
 		return 0;
 	}
-	double *ex=new double[lenx];
-	int32_t off=0;
+	t0=nanosec();
+	ok=calc(0,leny-1);
+	gatefullns += nanosec()-t0;
+	gatefullevals += evalsvoll;
+	gatepromoted++;
+	return ok;
+}
+
+void Ljapunow::gatestart(void) {
+	gateanz=gatepromoted=0;
+	gatethumbevals=gatefullevals=0;
+	gatethumbns=gatefullns=0;
+}
+
+void Ljapunow::gatereport(void) {
+	// saving in function evaluations: every dropped candidate would have
+	// cost a full image, against that stand all thumbnails
+	if ((gatediv<=0)||(gateanz<=0)) return;
+	const int64_t evalsvoll=(int64_t)lenx*leny*2*(iter0h+iter1h);
+	const int64_t ohne=(int64_t)gateanz*evalsvoll;
+	const int64_t mit=gatethumbevals+gatefullevals;
+	printf("\ngate: %i of %i candidates computed in full\n",gatepromoted,gateanz);
+	printf("thumbnails %.3lf sec, full images %.3lf sec\n",gatethumbns*1E-9,gatefullns*1E-9);
+	printf("evaluations %lld instead of %lld: %.1lf%% saved\n",
+		(long long)mit,(long long)ohne,(ohne>0) ? 100.0*(ohne-mit)/ohne : 0);
+}
+
+void Ljapunow::setheatmap(const int32_t an) {
+	if (kosten) { delete[] kosten; kosten=NULL; }
+	if (an) {
+		kosten=new float[lenx*leny];
+		for(int32_t i=0;i<(lenx*leny);i++) kosten[i]=0;
+	}
+}
+
+void Ljapunow::printstats(FILE* f) {
+	CalcStats summe;
+	for(int32_t i=0;i<statthreads;i++) summe.add(threadstats[i]);
+	fprintf(f,"last calc: %.3lf sec wall with %i threads\n",calcns*1E-9,statthreads);
+	fprintf(f,"pixels %lli  eval calls %lli  log calls %lli\n",(long long)summe.pixels,(long long)summe.evals,(long long)summe.logs);
+	fprintf(f,"skipped near-zero derivatives %lli  NaN orbits %lli\n",(long long)summe.skipped,(long long)summe.nanorbits);
+	fprintf(f,"transient %.3lf sec  computing %.3lf sec  cpu %.3lf sec (summed over threads)\n",
+		summe.ns[PHASE_TRANSIENT]*1E-9,summe.ns[PHASE_COMPUTE]*1E-9,summe.cpuns*1E-9);
+	fprintf(f,"last coloring %.3lf sec  saving since calc %.3lf sec\n",phasens[PHASE_COLORING]*1E-9,phasens[PHASE_SAVE]*1E-9);
+	if (aaidx) fprintf(f,"supersampling %.3lf sec  %i pixels refined  %.3lf samples per pixel\n",aans*1E-9,aaanz,1.0+(double)aaanz*(aasamples-1)/aalen);
+	for(int32_t i=0;i<statthreads;i++) {
+		fprintf(f,"  thread %3i: pixels %lli transient %.3lf computing %.3lf cpu %.3lf sec\n",
+			i,(long long)threadstats[i].pixels,threadstats[i].ns[PHASE_TRANSIENT]*1E-9,
+			threadstats[i].ns[PHASE_COMPUTE]*1E-9,threadstats[i].cpuns*1E-9);
+	}
+}
+
+void Ljapunow::savestatsjson(const char* fn) {
+	FILE *f=fopen(fn,"wt");
+	if (!f) { printf("Error opening %s\n",fn); return; }
+	CalcStats summe;
+	for(int32_t i=0;i<statthreads;i++) summe.add(threadstats[i]);
+	fprintf(f,"{\n\"function\": %i, \"lenx\": %i, \"leny\": %i, \"iter0\": %i, \"iter1\": %i, \"threads\": %i,\n",
+		fkt ? fkt->id : 0,lenx,leny,iter0,iter1,statthreads);
+	fprintf(f,"\"calc_wall_ns\": %lli, \"coloring_ns\": %lli, \"save_ns\": %lli,\n",
+		(long long)calcns,(long long)phasens[PHASE_COLORING],(long long)phasens[PHASE_SAVE]);
+	fprintf(f,"\"supersample_ns\": %lli, \"samples_per_pixel\": %.4lf,\n",
+		(long long)((aaidx) ? aans : 0),(aaidx) ? 1.0+(double)aaanz*(aasamples-1)/aalen : 1.0);
+	for(int32_t i=-1;i<statthreads;i++) {
+		const CalcStats& c=(i<0) ? summe : threadstats[i];
+		if (i<0) fprintf(f,"\"total\": "); 
+		else if (i==0) fprintf(f,",\n\"per_thread\": [\n"); 
+		else fprintf(f,",\n");
+		fprintf(f,"{\"pixels\": %lli, \"evals\": %lli, \"logs\": %lli, \"skipped\": %lli, \"nan_orbits\": %lli, ",
+			(long long)c.pixels,(long long)c.evals,(long long)c.logs,(long long)c.skipped,(long long)c.nanorbits);
+		fprintf(f,"\"transient_ns\": %lli, \"compute_ns\": %lli, \"cpu_ns\": %lli}",
+			(long long)c.ns[PHASE_TRANSIENT],(long long)c.ns[PHASE_COMPUTE],(long long)c.cpuns);
+	}
+	if (statthreads>0) fprintf(f,"\n]");
+	fprintf(f,"\n}\n");
+	fclose(f);
+}
+
+void Ljapunow::saveheatmap(const char* fn) {
+	// logarithmic cost per pixel: black (cheap) over blue and red to yellow (expensive)
+	if (!kosten) { printf("No cost map recorded. Use HEATMAP(1) and RUN first\n"); return; }
+	const int32_t anz=lenx*leny;
+	double kmin=0,kmax=0;
+	int32_t erster=1;
+	for(int32_t i=0;i<anz;i++) if (kosten[i]>0) {
+		const double k=log(kosten[i]);
+		if ((erster)||(k<kmin)) kmin=k;
+		if ((erster)||(k>kmax)) kmax=k;
+		erster=0;
+	}
+	const double breite=(kmax>kmin) ? kmax-kmin : 1;
+
+	Bitmap bmp;
+	bmp.setlenxy(lenx,leny);
+	for(int32_t i=0;i<anz;i++) {
+		double w=(kosten[i]>0) ? (log(kosten[i])-kmin)/breite : 0;
+		int32_t r,g,b;
+		if (w<(1.0/3)) { r=0; g=0; b=int32_t(w*3*255); }
+		else if (w<(2.0/3)) { r=int32_t((w*3-1)*255); g=0; b=255-r; }
+		else { r=255; g=int32_t((w*3-2)*255); b=0; }
+		bmp.bmp[3*i]=b;
+		bmp.bmp[3*i+1]=g;
+		bmp.bmp[3*i+2]=r;
+	}
+	bmp.save(fn);
+	printf("cost per pixel %.0lf..%.0lf ns\n",exp(kmin),exp(kmax));
+}
+
+void Ljapunow::printprofile(FILE* f) {
+	if (!profiling) { fprintf(f,"Profiling is off. Use PROFILE(1) and RUN first\n"); return; }
+	if (!perfok) {
+		fprintf(f,"Hardware performance counters not available (no Linux perf_event support or no permission, see /proc/sys/kernel/perf_event_paranoid)\n");
+		return;
+	}
+	char tmp[1024];
+	fprintf(f,"function %i sequence %s iterations (%i|%i) size (%i|%i) threads %i\n",
+		fkt ? fkt->id : 0,getSequence(tmp),iter0,iter1,lenx,leny,statthreads);
+	fprintf(f,"phase        thread      cycles       instr    IPC  branch-miss%%  cache-miss/ki      fp ops  bound\n");
+	const char* phasenname[ANZPHASES]={ "transient","computing","coloring","save" };
+
+	CalcStats summe;
+	for(int32_t i=0;i<statthreads;i++) summe.add(threadstats[i]);
+	for(int32_t ph=0;ph<=PHASE_COLORING;ph++) {
+		for(int32_t t=-1;t<statthreads;t++) {
+			if ((ph==PHASE_COLORING)&&(t>=0)) break;
+			const uint64_t* w;
+			if (ph==PHASE_COLORING) w=perfcoloring;
+			else w=(t<0) ? summe.perf[ph] : threadstats[t].perf[ph];
+			const double ipc=(w[PERF_CYCLES]>0) ? (double)w[PERF_INSTR]/w[PERF_CYCLES] : 0;
+			const double bm=(w[PERF_BRANCHES]>0) ? 100.0*w[PERF_BRANCHMISS]/w[PERF_BRANCHES] : 0;
+			const double cm=(w[PERF_INSTR]>0) ? 1000.0*w[PERF_CACHEMISS]/w[PERF_INSTR] : 0;
+			if (t<0) fprintf(f,"%-12s %6s",phasenname[ph],"all"); else fprintf(f,"%-12s %6i",phasenname[ph],t);
+			fprintf(f," %11llu %11llu %6.2lf %12.3lf %14.3lf ",
+				(unsigned long long)w[PERF_CYCLES],(unsigned long long)w[PERF_INSTR],ipc,bm,cm);
+			if (perffpraw) fprintf(f,"%11llu",(unsigned long long)w[PERF_FP]); else fprintf(f,"%11s","n/a");
+			// few instructions per cycle: waiting on dependencies or memory
+			fprintf(f,"  %s\n",(ipc<1.0) ? "latency" : "throughput");
+		}
+	}
+}
+
+void Ljapunow::setprecision(const int32_t p) {
+	if ((p<0)||(p>=ANZPRECISION)) precision=PRECISION_DOUBLE;
+	else precision=p;
+}
+
+void Ljapunow::checkprecision(void) {
+	// computes the current image with every tier and counts the pixels
+	// whose color differs from the reference tier. exps and tier are preserved
+	if ((!exps)||(!farbe)||(seqlen<=0)) { printf("Nothing to compute\n"); return; }
+
+	const int32_t anz=lenx*leny;
+	double* sicexps=new double[anz];
+	double* ref=new double[anz];
+	memcpy(sicexps,exps,anz*sizeof(double));
+	const int32_t sicprecision=precision;
+
+	printf("tier            sec   max deviation   color changed\n");
+	for(int32_t t=0;t<ANZPRECISION;t++) {
+		precision=t;
+		int64_t t0=nanosec();
+		calc(0,leny-1);
+		const double sec=(nanosec()-t0)*1E-9;
+		if (t==PRECISION_REFERENCE) memcpy(ref,exps,anz*sizeof(double));
+
+		double maxabw=0;
+		int32_t anzfarbe=0;
+		for(int32_t i=0;i<anz;i++) {
+			const double d=fabs(exps[i]-ref[i]);
+			if (d>maxabw) maxabw=d;
+			int32_t r1=0,g1=0,b1=0,r2=0,g2=0,b2=0;
+			farbe->farbe(exps[i],r1,g1,b1);
+			farbe->farbe(ref[i],r2,g2,b2);
+			if ((r1!=r2)||(g1!=g2)||(b1!=b2)) anzfarbe++;
+		}
+		printf("%-10s %9.3lf   %13le   %12.3lf%%%s\n",PRECISIONNAMES[t],sec,maxabw,
+			100.0*anzfarbe/anz,(t==sicprecision) ? "  (current)" : "");
+	}
+
+	precision=sicprecision;
+	memcpy(exps,sicexps,anz*sizeof(double));
+	delete[] sicexps;
+	delete[] ref;
+}
+
+char* Ljapunow::cachekey(int32_t& len,const int32_t teile) {
+	// canonical text of everything exps depend on, caller deletes it.
+	// teile: CACHEKEY_ bits of the optional parts
+	if (!fkt) return NULL;
+	FILE *f=tmpfile();
+	if (!f) return NULL;
+	char seq[256];
+	fprintf(f,"VERSION %i\n",CACHEVERSION);
+	fkt->cachekey(f);
+	fprintf(f,"ITER0 %i\nX0 %a\nSEQUENCE %s\n",iter0,x0,getSequence(seq));
+	if (mitC()) fprintf(f,"C %a\n",cwert);
+	if (teile & CACHEKEY_ITER1) fprintf(f,"ITER1 %i\n",iter1);
+	if (teile & CACHEKEY_GEOMETRY) {
+		fprintf(f,"SIZE %i %i\n",lenx,leny);
+		fprintf(f,"OL %a %a\nUL %a %a\nUR %a %a\n",upperleft.x,upperleft.y,lowerleft.x,lowerleft.y,lowerright.x,lowerright.y);
+	}
+	// the instruction sets give identical exponents, the tiers do not
+	fprintf(f,"PRECISION %i\n",precision);
+	if (warmdiv>0) fprintf(f,"WARM %i\n",warmdiv);
+	len=ftell(f);
+	char* erg=new char[len+1];
+	rewind(f);
+	len=fread(erg,1,len,f);
+	erg[len]=0;
+	fclose(f);
+	return erg;
+}
+
+int32_t Ljapunow::cacheload(void) {
+	// 1: exps taken from the cache. Damaged entries are removed
+	int32_t keylen;
+	char* key=cachekey(keylen);
+	if (!key) return 0;
+	char fn[1200];
+	sprintf(fn,"%s/%016llx.ljc",cachedir,(unsigned long long)fnv1a(key,keylen,0));
+	FILE *f=fopen(fn,"rb");
+	if (!f) { delete[] key; cachemisses++; return 0; }
+
+	int32_t ok=0;
+	char magic[4];
+	int32_t len=0,wx=0,wy=0;
+	uint64_t pruef=0;
+	char* key2=new char[keylen+1];
+	if (
+		(fread(magic,1,4,f)==4)&&(memcmp(magic,CACHEMAGIC,4)==0)&&
+		(fread(&len,sizeof(len),1,f)==1)&&(len==keylen)&&
+		(fread(key2,1,len,f)==(size_t)len)&&(memcmp(key,key2,len)==0)&&
+		(fread(&wx,sizeof(wx),1,f)==1)&&(fread(&wy,sizeof(wy),1,f)==1)&&
+		(wx==lenx)&&(wy==leny)&&
+		(fread(exps,sizeof(double),lenx*leny,f)==(size_t)(lenx*leny))&&
+		(fread(&pruef,sizeof(pruef),1,f)==1)&&
+		(pruef==fnv1a(exps,(int64_t)lenx*leny*sizeof(double),0))
+	) ok=1;
+	fclose(f);
+	delete[] key;
+	delete[] key2;
+
+	if (ok) {
+		#ifdef __linux__
+		utime(fn,NULL); // recently used
+		#endif
+		cachehits++;
+		return 1;
+	}
+	// hash collision or damaged file: the entry is rewritten after calc
+	printf("Cache entry %s damaged or foreign, removed\n",fn);
+	remove(fn);
+	cachedefekt++;
+	cachemisses++;
+	return 0;
+}
+
+void Ljapunow::cachestore(void) {
+	int32_t keylen;
+	char* key=cachekey(keylen);
+	if (!key) return;
+	char fn[1200],fntmp[1300];
+	sprintf(fn,"%s/%016llx.ljc",cachedir,(unsigned long long)fnv1a(key,keylen,0));
+	// written under a temporary name so readers never see half a file
+	sprintf(fntmp,"%s.%lli.tmp",fn,(long long)nanosec());
+	FILE *f=fopen(fntmp,"wb");
+	if (!f) { delete[] key; return; }
+	const uint64_t pruef=fnv1a(exps,(int64_t)lenx*leny*sizeof(double),0);
+	fwrite(CACHEMAGIC,1,4,f);
+	fwrite(&keylen,sizeof(keylen),1,f);
+	fwrite(key,1,keylen,f);
+	fwrite(&lenx,sizeof(lenx),1,f);
+	fwrite(&leny,sizeof(leny),1,f);
+	fwrite(exps,sizeof(double),lenx*leny,f);
+	int32_t ok=(fwrite(&pruef,sizeof(pruef),1,f)==1);
+	if (fclose(f)!=0) ok=0;
+	delete[] key;
+	if ((!ok)||(rename(fntmp,fn)!=0)) { remove(fntmp); return; }
+	cacheEvict();
+}
+
+void Ljapunow::setzustand(const int32_t an) {
+	// also called to drop the recorded state
+	zustand=an;
+	if (zpx) { delete[] zpx; zpx=NULL; }
+	if (zlambda) { delete[] zlambda; zlambda=NULL; }
+	if (zkey) { delete[] zkey; zkey=NULL; }
+	zschritte=-1;
+}
+
+int32_t Ljapunow::savestate(const char* fn) {
+	if ((!zpx)||(!zkey)||(zschritte<0)) return 0;
+	FILE *f=fopen(fn,"wb");
+	if (!f) return 0;
+	const int32_t keylen=strlen(zkey);
+	fwrite(STATEMAGIC,1,4,f);
+	fwrite(&keylen,sizeof(keylen),1,f);
+	fwrite(zkey,1,keylen,f);
+	fwrite(&lenx,sizeof(lenx),1,f);
+	fwrite(&leny,sizeof(leny),1,f);
+	fwrite(&zschritte,sizeof(zschritte),1,f);
+	fwrite(&zseqpos,sizeof(zseqpos),1,f);
+	fwrite(zpx,sizeof(double),lenx*leny,f);
+	fwrite(zlambda,sizeof(double),lenx*leny,f);
+	fclose(f);
+	return 1;
+}
+
+int32_t Ljapunow::loadstate(const char* fn) {
+	// switches state mode on if the file fits the image size
+	FILE *f=fopen(fn,"rb");
+	if (!f) return 0;
+	const int32_t siczustand=zustand;
+	char magic[4];
+	int32_t keylen=0,wx=0,wy=0,schritte=-1,pos=0;
+	if (
+		(fread(magic,1,4,f)!=4)||(memcmp(magic,STATEMAGIC,4)!=0)||
+		(fread(&keylen,sizeof(keylen),1,f)!=1)||(keylen<=0)||(keylen>(1 << 20))
+	) { fclose(f); return 0; }
+	char* key=new char[keylen+1];
+	const int32_t ok=
+		(fread(key,1,keylen,f)==(size_t)keylen)&&
+		(fread(&wx,sizeof(wx),1,f)==1)&&(fread(&wy,sizeof(wy),1,f)==1)&&
+		(wx==lenx)&&(wy==leny)&&
+		(fread(&schritte,sizeof(schritte),1,f)==1)&&(fread(&pos,sizeof(pos),1,f)==1);
+	key[keylen]=0;
+	if (!ok) { delete[] key; fclose(f); return 0; }
+	setzustand(1);
+	zpx=new double[lenx*leny];
+	zlambda=new double[lenx*leny];
+	if (
+		(fread(zpx,sizeof(double),lenx*leny,f)!=(size_t)(lenx*leny))||
+		(fread(zlambda,sizeof(double),lenx*leny,f)!=(size_t)(lenx*leny))
+	) { delete[] key; fclose(f); setzustand(siczustand); return 0; }
+	fclose(f);
+	zkey=key;
+	zschritte=schritte;
+	zseqpos=pos;
+	return 1;
+}
+
+void Ljapunow::setviewport(const int32_t an) {
+	// switching off frees the remembered image
+	viewport=an;
+	if (an) return;
+	if (vpexps) { delete[] vpexps; vpexps=NULL; }
+	if (vpkey) { delete[] vpkey; vpkey=NULL; }
+	vplenx=vpleny=0;
+}
+
+int32_t Ljapunow::viewportreuse(const char* key,const Point32_t& vx,const Point32_t& vy,uint8_t* bekannt,const int32_t kopieren,int32_t* genau) {
+	// marks and copies (kopieren=0: only marks) every pixel lying on the
+	// remembered grid (within 1E-6 of its spacing), returns their number.
+	// genau: how many of them have a bit-identical r. calcRows
+	// accumulates r along the rows, so r of both grids is accumulated
+	// here the same way; the others may differ from a fresh calc
+	if (genau) *genau=0;
+	for(int32_t i=0;i<(lenx*leny);i++) bekannt[i]=0;
+	if ((!vpexps)||(!vpkey)||(strcmp(key,vpkey)!=0)) return 0;
+	const double det=vpvx.x*vpvy.y-vpvx.y*vpvy.x;
+	if (det==0) return 0;
+
+	// old grid position i,j of pixel x,y is linear in x and y
+	const double dx=lowerleft.x-vpll.x,dy=lowerleft.y-vpll.y;
+	const double i0=(dx*vpvy.y-dy*vpvy.x)/det,j0=(vpvx.x*dy-vpvx.y*dx)/det;
+	const double ix=(vx.x*vpvy.y-vx.y*vpvy.x)/det,jx=(vpvx.x*vx.y-vpvx.y*vx.x)/det;
+	const double iy=(vy.x*vpvy.y-vy.y*vpvy.x)/det,jy=(vpvx.x*vy.y-vpvx.y*vy.x)/det;
+	const double EPS=1E-6;
+	// r of old row altj
+	double* altA=new double[vplenx];
+	double* altB=new double[vplenx];
+	int32_t altj=-1;
+	int32_t anz=0;
+	for(int32_t y=0;y<leny;y++) {
+		double A=lowerleft.x+y*vy.x,B=lowerleft.y+y*vy.y;
+		for(int32_t x=0;x<lenx;x++,A+=vx.x,B+=vx.y) {
+			const double i=i0+x*ix+y*iy,j=j0+x*jx+y*jy;
+			const double ri=floor(i+0.5),rj=floor(j+0.5);
+			if ((fabs(i-ri)>EPS)||(fabs(j-rj)>EPS)) continue;
+			if ((ri<0)||(rj<0)||(ri>=vplenx)||(rj>=vpleny)) continue;
+			const int32_t ii=(int32_t)ri,jj=(int32_t)rj;
+			if (kopieren) exps[y*lenx+x]=vpexps[jj*vplenx+ii];
+			bekannt[y*lenx+x]=1;
+			anz++;
+			if (!genau) continue;
+			if (jj!=altj) {
+				double a=vpll.x+jj*vpvy.x,b=vpll.y+jj*vpvy.y;
+				for(int32_t k=0;k<vplenx;k++) { altA[k]=a; altB[k]=b; a+=vpvx.x; b+=vpvx.y; }
+				altj=jj;
+			}
+			if ((A==altA[ii])&&(B==altB[ii])) (*genau)++;
+		}
+	}
+	delete[] altA;
+	delete[] altB;
+
+	return anz;
+}
+
+void Ljapunow::viewportstore(char* key,const Point32_t& vx,const Point32_t& vy) {
+	// takes over key
+	if ((!vpexps)||(vplenx*vpleny != lenx*leny)) {
+		if (vpexps) delete[] vpexps;
+		vpexps=new double[lenx*leny];
+	}
+	memcpy(vpexps,exps,lenx*leny*sizeof(double));
+	vplenx=lenx;
+	vpleny=leny;
+	vpll=lowerleft;
+	vpvx=vx;
+	vpvy=vy;
+	if (vpkey) delete[] vpkey;
+	vpkey=key;
+}
+
+void Ljapunow::setthreads(const int32_t n) {
+	threads=n;
+	if (threads<1) threads=1;
+	if (threads>MAXTHREADS) threads=MAXTHREADS;
+}
+
+void Ljapunow::setfarbe(IntervalColoring* f) {
+	if (farbe) delete farbe;
+	farbe=f;
+}
+
+void Ljapunow::setiter(const int32_t i0,const int32_t i1) {
+	iter0=i0; iter0h=(i0 >> 1);
+	iter1=i1; iter1h=(i1 >> 1); 
+	iter1d=(iter1h << 1);
+	INViter1d=1.0; INViter1d /= iter1d;
+}
+
+void Ljapunow::savedescr(const char* fn) {
+	FILE *fff=fopen(fn,"wt");
+	char tmp2[1024],tmp3[1024];
+
+	fprintf(fff,"x0=%lf, %i initial and %i computing iterations\n",x0,iter0,iter1);
+	fprintf(fff,"Trajectory function f(x)=%s\n",fkt->fktStr(tmp2));
+	fprintf(fff,"Computing function g(x)=%s\n",fkt->ablStr(tmp2));
+	fprintf(fff,"Sequence %s. Center (%.2lf/%.2lf) size=%.10lf\n",
+		getSequence(tmp3),
+		(lowerleft.x+lowerright.x)*0.5,
+		0.5*(lowerleft.y+upperleft.y),
+		sqrt( maximumD(
+			( (lowerleft.x-lowerright.x)*(lowerleft.x-lowerright.x) + (lowerleft.y-lowerright.y)*(lowerleft.y-lowerright.y) ),
+			( (lowerleft.x-upperleft.x)*(lowerleft.x-upperleft.x) + (lowerleft.y-upperleft.y)*(lowerleft.y-upperleft.y) )
+		) )
+	);
+
+	if (farbe->id == ID_FAERBUNG_INTERVALL) {
+		IntervalColoring* previ=(IntervalColoring*)farbe;
+		fprintf(fff,"Coloring with linear RGB value interpolation in several intervals\nLyapunov exponents less than %lf: RGB(%i,%i,%i)\n",previ->ints[0]->gl,previ->lr,previ->lg,previ->lb);
+		for(int32_t i=0;i<previ->intanz;i++) {
+			fprintf(fff,"in [%.2lf..%.2lf] (%i,%i,%i)..(%i,%i,%i)\n",previ->ints[i]->gl,previ->ints[i]->gr,
+			previ->ints[i]->lr,previ->ints[i]->lg,previ->ints[i]->lb,previ->ints[i]->rr,previ->ints[i]->rg,previ->ints[i]->rb);
+		}
+		fprintf(fff,"greater than %.2lf: (%i,%i,%i)\n",previ->ints[previ->intanz-1]->gr,previ->rr,previ->rg,previ->rb);
+	}
+	fclose(fff);
+}
+
+int32_t Ljapunow::iterStart(void) {
+	if ((!fkt) || (!farbe) ) return 0;
+	if (fkt->iterStart()<=0) return 0;
+	return 1;
+}
+
+int32_t Ljapunow::iterWeiter(void) {
+	if ((!fkt) || (!farbe) ) return 0;
+	if (fkt->iterWeiter()<=0) return 0;
+	return 1;
+}
+
+void Ljapunow::setlen(const int32_t xl,const int32_t yl) {
+	const int32_t nx=((xl >> 2) << 2);
+	const int32_t ny=((yl >> 2) << 2);
+	// the buffer is kept if the pixel count stays
+	if ((!exps)||(nx*ny != lenx*leny)) {
+		if (exps) delete[] exps;
+		exps=new double[nx*ny];
+	}
+	lenx=nx;
+	leny=ny;
+	aafrei();
+	skizzeok=0;
+	if (kosten) setheatmap(1);
+	if (zpx) setzustand(zustand);
+}
+
+void Ljapunow::saveexp(char *fn) {
+	TraceSpan span("saveexp");
+	int64_t t0=nanosec();
+	FILE *f=fopen(fn,"wb");
+	if (!f) { printf("Error writing %s\n",fn); return; }
+    fwrite(&lenx,sizeof(lenx),1,f);
+    fwrite(&leny,sizeof(leny),1,f);
+    fwrite(exps,sizeof(double),lenx*leny,f);
+    fclose(f);
+	// state next to the exponents: name.ljs
+	if ((zustand)&&(zschritte>=0)) {
+		char fs[1100];
+		strcpy(fs,fn);
+		stripext(fs);
+		strcat(fs,".ljs");
+		savestate(fs);
+	}
+	phasens[PHASE_SAVE] += nanosec()-t0;
+}
+
+int32_t Ljapunow::loadexp(char *fn) {
+    FILE *f=fopen(fn,"rb");
+	if (!f) return 0;
+
+    int32_t wx,wy;
+    fread(&wx,sizeof(lenx),1,f);
+	fread(&wy,sizeof(leny),1,f);
+	if ((wx!=lenx)||(wy!=leny)) {
+		fclose(f);
+		return 0;
+	}
+	aafrei();
+	skizzeok=0;
+	double *ex=new double[lenx];
+	int32_t off=0;
 	for(int32_t y=0;y<leny;y++) {
 		fread(ex,sizeof(double),lenx,f);
 		for(int32_t i=0;i<lenx;i++) exps[off++]=ex[i];
@@ -1643,26 +4855,55 @@ int32_t Ljapunow::loadexp(char *fn) {
 
 	delete[] ex;
 	fclose(f);
+
+	char fs[1100];
+	strcpy(fs,fn);
+	stripext(fs);
+	strcat(fs,".ljs");
+	if (loadstate(fs) > 0) printf("Pixel state loaded\n");
 	
 	return 1;
 }
 
 void Ljapunow::createBmp(Bitmap* bmp) {
+	TraceSpan span("coloring");
+	PerfCounters pc;
+	uint64_t pw0[ANZPERF],pw1[ANZPERF];
+	const int32_t perf=(profiling) ? pc.open(perffpraw) : 0;
+	if (perf) pc.read(pw0);
+	int64_t t0=nanosec();
 	bmp->setlenxy(lenx,leny);
-    int32_t offsetbmp=0,offsetexp=0;
-    int32_t r,g,b;
-    for(int32_t y=0;y<leny;y++) {
-		for(int32_t x=0;x<lenx;x++) {
-			farbe->farbe(exps[offsetexp],r,g,b);
-            bmp->bmp[offsetbmp]=b;
-            bmp->bmp[offsetbmp+1]=g;
-            bmp->bmp[offsetbmp+2]=r;
-            offsetbmp+=3; offsetexp++;
-		} // x
-    } // y
+	switch (isa) {
+		case ISA_AVX512: color512(farbe,exps,bmp->bmp,lenx*leny); break;
+		case ISA_AVX2: coloravx2(farbe,exps,bmp->bmp,lenx*leny); break;
+		default: colorsse2(farbe,exps,bmp->bmp,lenx*leny); break;
+	}
+	// supersampled pixels: mean color of all their samples
+	if ((aaidx)&&(aalen==lenx*leny)) {
+		const int32_t extra=aasamples-1;
+		int32_t r,g,b;
+		for(int32_t i=0;i<aalen;i++) {
+			if (aaidx[i]<0) continue;
+			uint8_t* p=&bmp->bmp[3*i];
+			int32_t sb=p[0],sg=p[1],sr=p[2];
+			for(int32_t k=0;k<extra;k++) {
+				farbe->farbe(aaexps[aaidx[i]+k],r,g,b);
+				sr += r; sg += g; sb += b;
+			}
+			p[0]=(sb+aasamples/2)/aasamples;
+			p[1]=(sg+aasamples/2)/aasamples;
+			p[2]=(sr+aasamples/2)/aasamples;
+		}
+	}
+	phasens[PHASE_COLORING]=nanosec()-t0;
+	if (perf) {
+		pc.read(pw1);
+		for(int32_t k=0;k<ANZPERF;k++) perfcoloring[k]=pw1[k]-pw0[k];
+	}
 }
 
 void Ljapunow::savebmp(char *fn,Bitmap* bmp) {
+	TraceSpan span("savebmp");
 	int32_t neu=0;
 	if (!bmp) {
 		bmp=new Bitmap;
@@ -1670,10 +4911,55 @@ void Ljapunow::savebmp(char *fn,Bitmap* bmp) {
 	}
 
 	createBmp(bmp);
+	int64_t t0=nanosec();
 	bmp->save(fn);
+	phasens[PHASE_SAVE] += nanosec()-t0;
 	if (neu) delete bmp;
 };
 
+void Ljapunow::savepartial(const char* name) {
+	// name.bmp/.par/.ljd while calc runs or after it was cancelled:
+	// rows not yet computed are NaN in the exponents and black.
+	// The flags are read before the exponents, so a row finishing in
+	// between counts as not done rather than being saved half-written
+	const int32_t n=lenx*leny;
+	uint8_t* fertig=new uint8_t[leny];
+	for(int32_t y=0;y<leny;y++) fertig[y]=
+		((!zeilefertig)||(zeilefertiglen!=leny)) ? 1 : zeilefertig[y].load(std::memory_order_acquire);
+	double* kopie=new double[n];
+	memcpy(kopie,exps,n*sizeof(double));
+	Bitmap bmp;
+	bmp.setlenxy(lenx,leny);
+	switch (isa) {
+		case ISA_AVX512: color512(farbe,kopie,bmp.bmp,n); break;
+		case ISA_AVX2: coloravx2(farbe,kopie,bmp.bmp,n); break;
+		default: colorsse2(farbe,kopie,bmp.bmp,n); break;
+	}
+	int32_t anz=0;
+	for(int32_t y=0;y<leny;y++) {
+		if (fertig[y]) { anz++; continue; }
+		for(int32_t x=0;x<lenx;x++) kopie[y*lenx+x]=NAN;
+		memset(&bmp.bmp[y*bmp.ybytes],0,bmp.ybytes);
+	}
+
+	char fn[1100];
+	sprintf(fn,"%s.bmp",name);
+	bmp.save(fn);
+	sprintf(fn,"%s.par",name);
+	savepar(fn);
+	sprintf(fn,"%s.ljd",name);
+	FILE *f=fopen(fn,"wb");
+	if (f) {
+		fwrite(&lenx,sizeof(lenx),1,f);
+		fwrite(&leny,sizeof(leny),1,f);
+		fwrite(kopie,sizeof(double),n,f);
+		fclose(f);
+	}
+	delete[] kopie;
+	delete[] fertig;
+	printf("%i of %i rows saved to %s\n",anz,leny,name);
+}
+
 char* Ljapunow::getSequence(char* s) {
 	s[0]=0;
 	for(int32_t i=0;i<seqlen;i++) s[i]='A'+sequence[i];
@@ -1682,7 +4968,14 @@ char* Ljapunow::getSequence(char* s) {
 }
 
 void Ljapunow::savepar(char *fn) {
+	TraceSpan span("savepar");
 	FILE *f=fopen(fn,"wt");
+	if (!f) return;
+	savepar(f);
+	fclose(f);
+}
+
+void Ljapunow::savepar(FILE* f) {
     fprintf(f,"FUNKTION\n");
     if (fkt) fkt->save(f);
     fprintf(f,"FAERBUNG\n");
@@ -1691,15 +4984,15 @@ void Ljapunow::savepar(char *fn) {
     fprintf(f,"LENY\n%i\n",leny);
     fprintf(f,"ITER0\n%i\n",iter0);
     fprintf(f,"ITER1\n%i\n",iter1);
-    fprintf(f,"X0\n%le\n",x0);
+    fprintf(f,"X0\n%.17le\n",x0);
     fprintf(f,"SEQUENZ\n");
     for(int32_t i=0;i<seqlen;i++) fprintf(f,"%c",'A'+sequence[i]);
     fprintf(f,"\n");
-    fprintf(f,"OL\n%le\n%le\n",upperleft.x,upperleft.y);
-    fprintf(f,"UL\n%le\n%le\n",lowerleft.x,lowerleft.y);
-    fprintf(f,"UR\n%le\n%le\n",lowerright.x,lowerright.y);
-
-    fclose(f);
+    fprintf(f,"OL\n%.17le\n%.17le\n",upperleft.x,upperleft.y);
+    fprintf(f,"UL\n%.17le\n%.17le\n",lowerleft.x,lowerleft.y);
+    fprintf(f,"UR\n%.17le\n%.17le\n",lowerright.x,lowerright.y);
+	if (precision!=PRECISION_DOUBLE) fprintf(f,"PRECISION\n%i\n",precision);
+	if (mitC()) fprintf(f,"C\n%.17le\n",cwert);
 }
 
 void Ljapunow::centerPixel(const int32_t px,const int32_t py) {
@@ -1722,40 +5015,262 @@ void Ljapunow::centerPixel(const int32_t px,const int32_t py) {
 	upperleft.y=upperleft.y+PX.y-M.y;
 }
 
-void Ljapunow::tile(char* fnprefix,const int32_t anzx,const int32_t anzy) {
-	Point32_t siclowerleft,siclowerright,sicupperleft;
-	
-	siclowerleft.x=lowerleft.x;
-	siclowerleft.y=lowerleft.y;
-	siclowerright.x=lowerright.x;
-	siclowerright.y=lowerright.y;
-	sicupperleft.x=upperleft.x;
-	sicupperleft.y=upperleft.y;
-
-    Point32_t vx,vy;
-    vx.x=(lowerright.x-lowerleft.x)/anzx; vx.y=(lowerright.y-lowerleft.y)/anzx;
-    vy.x=(upperleft.x-lowerleft.x)/anzy; vy.y=(upperleft.y-lowerleft.y)/anzy;
-
-	int32_t ctr=1, anz=anzx*anzy;
+void tileWorker(TileArbeit* a,Ljapunow* lj,const int32_t nr) {
+	const int32_t anz=a->anzx*a->anzy;
+	char tmp[1100];
+	Bitmap bmp;
+	tracetid=tracetidnext.fetch_add(1);
+	while (1) {
+		const int32_t i=a->next.fetch_add(1);
+		if (i>=anz) break;
+		if (*a->abbruch) break;
+		// numbering as before: columns from the left, in each from below
+		const int32_t x=i / a->anzy,y=i % a->anzy,ctr=i+1;
+		TraceSpan frame("frame",ctr);
+		lj->lowerleft.x=a->ll.x+x*a->vx.x+y*a->vy.x;
+		lj->lowerleft.y=a->ll.y+x*a->vx.y+y*a->vy.y;
+		lj->lowerright.x=a->ll.x+(x+1)*a->vx.x+y*a->vy.x;
+		lj->lowerright.y=a->ll.y+(x+1)*a->vx.y+y*a->vy.y;
+		lj->upperleft.x=a->ll.x+x*a->vx.x+(y+1)*a->vy.x;
+		lj->upperleft.y=a->ll.y+x*a->vx.y+(y+1)*a->vy.y;
+
+		lj->calc(0,lj->leny-1);
+		if (a->einzeln) {
+			sprintf(tmp,"_walktile_%s_%06i.par",a->prefix,ctr); 
+			lj->savepar(tmp);
+			sprintf(tmp,"_walktile_%s_%06i.bmp",a->prefix,ctr); 
+			lj->savebmp(tmp,&bmp);
+		} else lj->createBmp(&bmp);
+
+		// row r of the tile is row y*leny+r of the mosaic, both bottom up
+		{
+			std::lock_guard<std::mutex> lock(a->m);
+			for(int32_t r=0;r<lj->leny;r++) {
+				const int64_t pos=((int64_t)y*lj->leny+r)*a->breite+(int64_t)x*lj->lenx;
+				fseek64(a->fljd,2*sizeof(int32_t)+pos*sizeof(double));
+				fwrite(&lj->exps[r*lj->lenx],sizeof(double),lj->lenx,a->fljd);
+				fseek64(a->fbmp,BMPKOPF+pos*3);
+				fwrite(&bmp.bmp[r*bmp.ybytes],1,bmp.ybytes,a->fbmp);
+			}
+		}
+		const int32_t f=a->fertig.fetch_add(1)+1;
+		printf("tile %i/%i (%i done)\n",ctr,anz,f);
+	}
+	tracetid=0;
+}
+
+void Ljapunow::tile(char* fnprefix,const int32_t anzx,const int32_t anzy,const int32_t einzeln) {
+	// the tiles are computed in parallel by copies of the current
+	// settings, one tile in memory per copy, and streamed into one
+	// mosaic _walktile_prefix_mosaic.ljd/.bmp/.par of anzx*lenx x
+	// anzy*leny pixels. einzeln: also par and bmp of every tile
+	if ((!fkt)||(!farbe)||(anzx<1)||(anzy<1)) return;
+	const int32_t anz=anzx*anzy;
+
+	TileArbeit a;
+	a.anzx=anzx;
+	a.anzy=anzy;
+	a.einzeln=einzeln;
+	a.prefix=fnprefix;
+	a.ll=lowerleft;
+    a.vx.x=(lowerright.x-lowerleft.x)/anzx; a.vx.y=(lowerright.y-lowerleft.y)/anzx;
+    a.vy.x=(upperleft.x-lowerleft.x)/anzy; a.vy.y=(upperleft.y-lowerleft.y)/anzy;
+	a.breite=(int64_t)anzx*lenx;
+	a.next=0;
+	a.fertig=0;
+	a.abbruch=&abbruch;
+
+	// mosaic parameters: same rhomboid, size of all tiles
 	char tmp[1000];
-	for(int32_t x=0;x<anzx;x++) {
-		for(int32_t y=0;y<anzy;y++) {
-			printf("\ntile %i/%i ... ",ctr,anz);
-			lowerleft.x=siclowerleft.x+x*vx.x+y*vy.x;
-			lowerleft.y=siclowerleft.y+x*vx.y+y*vy.y;
-			lowerright.x=siclowerleft.x+(x+1)*vx.x+y*vy.x;
-			lowerright.y=siclowerleft.y+(x+1)*vx.y+y*vy.y;
-			upperleft.x=siclowerleft.x+x*vx.x+(y+1)*vy.x;
-			upperleft.y=siclowerleft.y+x*vx.y+(y+1)*vy.y;
-
-			calc(0,leny-1);
-			sprintf(tmp,"_walktile_%s_%06i.par",fnprefix,ctr); 
-			savepar(tmp);
-			sprintf(tmp,"_walktile_%s_%06i.bmp",fnprefix,ctr); 
-			savebmp(tmp,NULL);
-			ctr++;
-		} // y
-	} // x
+	const int32_t siclenx=lenx,sicleny=leny;
+	lenx=anzx*siclenx;
+	leny=anzy*sicleny;
+	sprintf(tmp,"_walktile_%s_mosaic.par",fnprefix);
+	savepar(tmp);
+	lenx=siclenx;
+	leny=sicleny;
+
+	sprintf(tmp,"_walktile_%s_mosaic.ljd",fnprefix);
+	a.fljd=fopen(tmp,"wb");
+	sprintf(tmp,"_walktile_%s_mosaic.bmp",fnprefix);
+	a.fbmp=fopen(tmp,"wb");
+	if ((!a.fljd)||(!a.fbmp)) {
+		printf("Error writing mosaic %s\n",tmp);
+		if (a.fljd) fclose(a.fljd);
+		if (a.fbmp) fclose(a.fbmp);
+		return;
+	}
+	const int32_t mx=anzx*lenx,my=anzy*leny;
+	fwrite(&mx,sizeof(mx),1,a.fljd);
+	fwrite(&my,sizeof(my),1,a.fljd);
+	bmpKopf(a.fbmp,mx,my);
+
+	// tiles in parallel, remaining threads inside calc
+	const int32_t anzt=minimumI(threads,anz);
+	savepar((char*)TILEPAR);
+	Ljapunow* lj[MAXTHREADS];
+	for(int32_t t=0;t<anzt;t++) {
+		lj[t]=new Ljapunow;
+		lj[t]->quiet=1;
+		lj[t]->loadpar((char*)TILEPAR);
+		lj[t]->setthreads(threads/anzt);
+		lj[t]->setprecision(precision);
+		lj[t]->warmdiv=warmdiv;
+	}
+	int64_t t0=nanosec();
+	if (anzt<=1) tileWorker(&a,lj[0],0);
+	else {
+		std::thread* th[MAXTHREADS];
+		for(int32_t t=0;t<anzt;t++) th[t]=new std::thread(tileWorker,&a,lj[t],t);
+		for(int32_t t=0;t<anzt;t++) { th[t]->join(); delete th[t]; }
+	}
+	for(int32_t t=0;t<anzt;t++) delete lj[t];
+	fclose(a.fljd);
+	fclose(a.fbmp);
+	printf("mosaic %i x %i of %i tiles in %.3lf sec, %i at a time\n",mx,my,anz,(nanosec()-t0)*1E-9,anzt);
+}
+
+void volumeWorker(VolumeArbeit* a,Ljapunow* lj,const int32_t nr) {
+	const int32_t K=VOLCHUNK;
+	const int32_t lenx=lj->lenx,leny=lj->leny;
+	double* brick=new double[K*K];
+	tracetid=tracetidnext.fetch_add(1);
+	while (1) {
+		const int32_t k=a->next.fetch_add(1);
+		if (k>=a->anz) break;
+		if (*a->abbruch) break;
+		TraceSpan frame("slice",k);
+		lj->cwert=a->c0+k*a->dc;
+		lj->calc(0,leny-1);
+
+		{
+			// slice k is layer k % K of the chunks bz=k/K, one
+			// contiguous K x K block in each, NaN beyond the image.
+			// The last chunks in z are only as deep as the slices left
+			std::lock_guard<std::mutex> lock(a->m);
+			const int64_t bz=k/K,zz=k%K;
+			const int64_t kz=minimumI(K,a->anz-bz*K);
+			for(int32_t by=0;by<a->nby;by++) for(int32_t bx=0;bx<a->nbx;bx++) {
+				for(int32_t yy=0;yy<K;yy++) {
+					const int32_t y=by*K+yy;
+					for(int32_t xx=0;xx<K;xx++) {
+						const int32_t x=bx*K+xx;
+						brick[yy*K+xx]=((x<lenx)&&(y<leny)) ? lj->exps[y*lenx+x] : NAN;
+					}
+				}
+				const int64_t chunk=by*a->nbx+bx;
+				const int64_t pos=((bz*K*a->nby*a->nbx+chunk*kz+zz)*K*K)*sizeof(double);
+				fseek64(a->f,4*sizeof(int32_t)+2*sizeof(double)+pos);
+				fwrite(brick,sizeof(double),K*K,a->f);
+			}
+		}
+		if (a->xz) {
+			memcpy(&a->xz[(int64_t)k*lenx],&lj->exps[(leny/2)*lenx],lenx*sizeof(double));
+			for(int32_t y=0;y<leny;y++) a->yz[(int64_t)k*leny+y]=lj->exps[y*lenx+lenx/2];
+			if (k==(a->anz/2)) memcpy(a->xy,lj->exps,(int64_t)lenx*leny*sizeof(double));
+		}
+		const int32_t f=a->fertig.fetch_add(1)+1;
+		printf("slice %i/%i C=%.6lf (%i done)\n",k+1,a->anz,lj->cwert,f);
+	}
+	delete[] brick;
+	tracetid=0;
+}
+
+void volumeVorschau(IntervalColoring* farbe,const double* w,const int32_t xl,const int32_t yl,const char* fn) {
+	Bitmap bmp;
+	bmp.setlenxy(xl,yl);
+	switch (isa) {
+		case ISA_AVX512: color512(farbe,w,bmp.bmp,xl*yl); break;
+		case ISA_AVX2: coloravx2(farbe,w,bmp.bmp,xl*yl); break;
+		default: colorsse2(farbe,w,bmp.bmp,xl*yl); break;
+	}
+	bmp.save((char*)fn);
+}
+
+int32_t Ljapunow::volume(const char* name,const int32_t anz,const double c0,const double c1,const int32_t vorschau) {
+	// anz slices of the current image with C running from c0 to c1,
+	// computed in parallel by copies of the current settings, one slice
+	// in memory per copy, and streamed into name.ljv: lenx, leny, anz,
+	// VOLCHUNK as int32, c0, c1 as double, then chunks of VOLCHUNK^3
+	// exponents, x fastest, then y, then z, each with x fastest, then
+	// y (bottom up), then z. The last chunks in z hold only the
+	// remaining anz % VOLCHUNK slices. vorschau: name_xy/_xz/_yz.bmp through the
+	// middle of the volume. 1: done, 0: cancelled
+	if ((!fkt)||(!farbe)||(seqlen<=0)||(anz<1)) { printf("Nothing to compute\n"); return -1; }
+	if (!mitC()) printf("Sequence without C, all slices are equal\n");
+	const int32_t K=VOLCHUNK;
+
+	VolumeArbeit a;
+	a.anz=anz;
+	a.nbx=(lenx+K-1)/K;
+	a.nby=(leny+K-1)/K;
+	a.c0=c0;
+	a.dc=(anz>1) ? (c1-c0)/(anz-1) : 0.0;
+	a.next=0;
+	a.fertig=0;
+	a.abbruch=&abbruch;
+	a.xy=a.xz=a.yz=NULL;
+
+	char fn[1100];
+	sprintf(fn,"%s.ljv",name);
+	a.f=fopen(fn,"wb");
+	if (!a.f) { printf("Error writing %s\n",fn); return -1; }
+	const int32_t kopf[4]={ lenx,leny,anz,K };
+	fwrite(kopf,sizeof(int32_t),4,a.f);
+	fwrite(&c0,sizeof(double),1,a.f);
+	fwrite(&c1,sizeof(double),1,a.f);
+	const int64_t nbz=(anz+K-1)/K;
+	printf("volume %s: %i x %i x %i, %lli chunks, %.1lf MB\n",fn,lenx,leny,anz,
+		(long long)(nbz*a.nby*a.nbx),((int64_t)a.nby*a.nbx*K*K*anz*sizeof(double))/1048576.0);
+	if (vorschau) {
+		a.xy=new double[(int64_t)lenx*leny];
+		a.xz=new double[(int64_t)lenx*anz];
+		a.yz=new double[(int64_t)leny*anz];
+	}
+	const double sicc=cwert;
+	cwert=c0;
+	sprintf(fn,"%s.par",name);
+	savepar(fn);
+
+	// slices in parallel, remaining threads inside calc
+	const int32_t anzt=minimumI(threads,anz);
+	savepar((char*)VOLPAR);
+	cwert=sicc;
+	Ljapunow* lj[MAXTHREADS];
+	for(int32_t t=0;t<anzt;t++) {
+		lj[t]=new Ljapunow;
+		lj[t]->quiet=1;
+		lj[t]->loadpar((char*)VOLPAR);
+		lj[t]->setthreads(threads/anzt);
+		lj[t]->setprecision(precision);
+		lj[t]->warmdiv=warmdiv;
+	}
+	int64_t t0=nanosec();
+	if (anzt<=1) volumeWorker(&a,lj[0],0);
+	else {
+		std::thread* th[MAXTHREADS];
+		for(int32_t t=0;t<anzt;t++) th[t]=new std::thread(volumeWorker,&a,lj[t],t);
+		for(int32_t t=0;t<anzt;t++) { th[t]->join(); delete th[t]; }
+	}
+	for(int32_t t=0;t<anzt;t++) delete lj[t];
+	fclose(a.f);
+	const int32_t fertig=a.fertig;
+	printf("%i of %i slices in %.3lf sec, %i at a time\n",fertig,anz,(nanosec()-t0)*1E-9,anzt);
+
+	if (vorschau) {
+		if (fertig==anz) {
+			sprintf(fn,"%s_xy.bmp",name);
+			volumeVorschau(farbe,a.xy,lenx,leny,fn);
+			sprintf(fn,"%s_xz.bmp",name);
+			volumeVorschau(farbe,a.xz,lenx,anz,fn);
+			sprintf(fn,"%s_yz.bmp",name);
+			volumeVorschau(farbe,a.yz,leny,anz,fn);
+		}
+		delete[] a.xy;
+		delete[] a.xz;
+		delete[] a.yz;
+	}
+	return (fertig==anz) ? 1 : 0;
 }
 
 void Ljapunow::crop(const int32_t pulneux,const int32_t pulneuy,const int32_t porneux,const int32_t porneuy) {
@@ -1846,6 +5361,11 @@ void Ljapunow::setPosition(
 	upperleft.y=upley;
 }
 
+int32_t Ljapunow::mitC(void) {
+	for(int32_t i=0;i<seqlen;i++) if (sequence[i]==2) return 1;
+	return 0;
+}
+
 void Ljapunow::setSequence(char *s) {
 	s[255]=0;
 	upper(s);
@@ -1853,6 +5373,7 @@ void Ljapunow::setSequence(char *s) {
     for(int32_t i=0;i<seqlen;i++) {
 		if (s[i]=='A') sequence[i]=0;
 		else if (s[i]=='B') sequence[i]=1;
+		else if (s[i]=='C') sequence[i]=2;
 		else {
 			printf("Error in sequence.\n");
 			seqlen=0;
@@ -1877,14 +5398,27 @@ int32_t Bitmap::setlenxy(const int32_t xl,const int32_t yl) {
 	return 1;
 }
 
-void Bitmap::save(const char* fn) {
-	FILE *fbmp = fopen(fn,"wb");
-	writehex(fbmp,"424DF6C62D00000000003600000028000000");
-	uint32_t w = xlen;
+void bmpKopf(FILE* fbmp,const int32_t xl,const int32_t yl) {
+	// 24 bit, rows without padding as widths are multiples of 4.
+	// Sizes beyond 4 GB are written as 0
+	const int64_t daten=(int64_t)xl*yl*3;
+	uint32_t w=(daten+BMPKOPF) > 0xFFFFFFFFLL ? 0 : (uint32_t)(daten+BMPKOPF);
+	writehex(fbmp,"424D");
 	fwrite(&w,sizeof(w),1,fbmp);
-	w = ylen; 
+	writehex(fbmp,"000000003600000028000000");
+	w = xl;
 	fwrite(&w,sizeof(w),1,fbmp);
-	writehex(fbmp,"0100180000000000C0C62D00C40E0000C40E00000000000000000000");
+	w = yl; 
+	fwrite(&w,sizeof(w),1,fbmp);
+	writehex(fbmp,"0100180000000000");
+	w=(daten > 0xFFFFFFFFLL) ? 0 : (uint32_t)daten;
+	fwrite(&w,sizeof(w),1,fbmp);
+	writehex(fbmp,"C40E0000C40E00000000000000000000");
+}
+
+void Bitmap::save(const char* fn) {
+	FILE *fbmp = fopen(fn,"wb");
+	bmpKopf(fbmp,xlen,ylen);
 	fwrite(bmp,bytes,1,fbmp);
 
 	fclose(fbmp);
@@ -1904,133 +5438,1881 @@ Bitmap::~Bitmap(void) {
 }
 
 
-// main routine
-
-int32_t main(int32_t argc,char** argv) {
-	srand(time(NULL));
-	ljap=new Ljapunow;
-	ffarbe=NULL;
-	int32_t iterfilecount=1;
-	int32_t tilefilenr=1;
+void benchFormula(Ljapunow* lj) {
+	// every built-in function against its compiled formula with
+	// the current image settings. exps in memory are preserved
+	if ((!lj->exps)||(lj->seqlen<=0)) { printf("Nothing to compute\n"); return; }
 
-	char tmp[1000],utmp[1000];
-	int32_t defect=0;
+	const int32_t anz=lj->lenx*lj->leny;
+	double* sicexps=new double[anz];
+	double* refexps=new double[anz];
+	memcpy(sicexps,lj->exps,anz*sizeof(double));
+	Function* sicfkt=lj->fkt;
+	int32_t ok=1;
 
-	while (1) {
-		printf("\n\n\nLjapunow\n");
-		if (defect>0) {
-			printf("\n\nError in function. Load anew recommended\n\n");
-		} else {
-			if (ljap->fn[0]>0) printf("File %s\n",ljap->fn);
-			if (ljap->fkt) printf("function %s\n",ljap->fkt->fktStr(tmp)); else printf("Function undefiniert\n");
-			printf("upper left(%le|%le)\nlower left(%le|%le)\nlower right(%le|%le)\n",ljap->upperleft.x,ljap->upperleft.y,ljap->lowerleft.x,ljap->lowerleft.y,ljap->lowerright.x,ljap->lowerright.y);
-			printf("Image size (%i|%i)\n",ljap->lenx,ljap->leny);
-			printf("sequence %s\n",ljap->getSequence(tmp));
-			printf("iterations (%i|%i)\n",ljap->iter0,ljap->iter1);
-			printf("================================\n\n");
+	printf("id   builtin sec   formula sec   factor   max deviation\n");
+	for(int32_t k=0;BUILTINFORMULAS[k].id>0;k++) {
+		Function* pb=getNewFunction(BUILTINFORMULAS[k].id);
+		FunctionFormula* pf=new FunctionFormula;
+		if (pf->setformula(BUILTINFORMULAS[k].f,BUILTINFORMULAS[k].g) <= 0) {
+			delete pb; delete pf;
+			ok=0;
+			continue;
 		}
+		pb->set_b(2.7);
+		pf->set_b(2.7);
+
+		lj->fkt=pb;
+		clock_t c0=clock();
+		lj->calc(0,lj->leny-1);
+		const double tb=(double)(clock()-c0)/CLOCKS_PER_SEC;
+		memcpy(refexps,lj->exps,anz*sizeof(double));
+
+		lj->fkt=pf;
+		c0=clock();
+		lj->calc(0,lj->leny-1);
+		const double tf=(double)(clock()-c0)/CLOCKS_PER_SEC;
+
+		double maxabw=0;
+		for(int32_t i=0;i<anz;i++) {
+			const double d=fabs(lj->exps[i]-refexps[i]);
+			if (d>maxabw) maxabw=d;
+		}
+		const double faktor=(tb>0) ? tf/tb : 0;
+		if (faktor>FORMULAFACTOR) ok=0;
+		printf("%2i   %11.3lf   %11.3lf   %6.2lf   %le\n",BUILTINFORMULAS[k].id,tb,tf,faktor,maxabw);
 
-		printf("\n> ");
-		gets(tmp);
-		defect=0; 
+		delete pb;
+		delete pf;
+	}
+	printf("Formulas %s within factor %.1lf of the built-in functions\n",ok ? "are" : "are NOT",FORMULAFACTOR);
+
+	lj->fkt=sicfkt;
+	memcpy(lj->exps,sicexps,anz*sizeof(double));
+	delete[] sicexps;
+	delete[] refexps;
+}
+
+
+void benchTemplates(const int32_t size,const int32_t maxthreads,const char* fnjson) {
+	// computes the shipped templates at a fixed size with 1,2,4..maxthreads
+	// threads and compares the exponents against golden reference
+	// exponents made with libm sin/cos (_bench_*_size_iter0_iter1_ref.ljd,
+	// made if missing) for accuracy, and at BENCHREFLEN against the
+	// committed BENCHREFDIR/*.ljd for changes. The result cache is off meanwhile
+	FILE *fj=fopen(fnjson,"wt");
+	if (!fj) { printf("Error opening %s\n",fnjson); return; }
+	const int64_t siccachemax=cachemax;
+	cachemax=0;
+	fprintf(fj,"{\n\"size\": %i,\n\"results\": [\n",size);
+	int32_t erster=1;
+	char fn[1024];
+
+	printf("template     id threads  Mpix*it/s  transient  compute  coloring   save   max err  mean err  color changed\n");
+	for(int32_t k=0;BENCHTEMPLATES[k];k++) {
+		Ljapunow lj;
+		sprintf(fn,"%s.par",BENCHTEMPLATES[k]);
+		if (lj.loadpar(fn) <= 0) { printf("%s not found\n",fn); continue; }
+		lj.setlen(size,size);
+		const int32_t anz=lj.lenx*lj.leny;
+		const double mpixit=(double)anz*(lj.iter0h+lj.iter1h)*2.0*1E-6;
+
+		double* ref=new double[anz];
+		sprintf(fn,"_bench_%s_%i_%i_%i_ref.ljd",BENCHTEMPLATES[k],lj.lenx,lj.iter0,lj.iter1);
+		if (lj.loadexp(fn) <= 0) {
+			const int32_t sicprecision=lj.precision;
+			lj.precision=PRECISION_REFERENCE;
+			lj.calc(0,lj.leny-1);
+			lj.precision=sicprecision;
+			lj.saveexp(fn);
+		}
+		memcpy(ref,lj.exps,anz*sizeof(double));
+
+		// regression check against the committed reference
+		int32_t refanders=-1;
+		double refmaxerr=0;
+		{
+			Ljapunow lr;
+			sprintf(fn,"%s.par",BENCHTEMPLATES[k]);
+			lr.loadpar(fn);
+			lr.setlen(BENCHREFLEN,BENCHREFLEN);
+			lr.calc(0,lr.leny-1);
+			const int32_t anzr=lr.lenx*lr.leny;
+			double* neu=new double[anzr];
+			memcpy(neu,lr.exps,anzr*sizeof(double));
+			sprintf(fn,"%s/%s.ljd",BENCHREFDIR,BENCHTEMPLATES[k]);
+			if (lr.loadexp(fn) > 0) {
+				refanders=0;
+				for(int32_t i=0;i<anzr;i++) {
+					const double a=neu[i],b=lr.exps[i];
+					if ((a!=a)&&(b!=b)) continue; // both NaN
+					if (a==b) continue;
+					refanders++;
+					const double d=fabs(a-b);
+					if (d>refmaxerr) refmaxerr=d;
+				}
+			} else {
+				memcpy(lr.exps,neu,anzr*sizeof(double));
+				printf("%s missing, written as new reference\n",fn);
+				lr.saveexp(fn);
+			}
+			delete[] neu;
+		}
 
-		chomp(tmp);	sprintf(utmp,"%s",tmp);
-		for(int32_t i=(strlen(tmp)-1);i>=0;i--) if (tmp[i]==')') { tmp[i]=0; break; }
-		upper(utmp);
+		for(int32_t t=1;t<=maxthreads;t=(t<maxthreads)&&(t+t>maxthreads) ? maxthreads : t+t) {
+			lj.setthreads(t);
+			int64_t t0=nanosec();
+			lj.calc(0,lj.leny-1);
+			const double wall=(nanosec()-t0)*1E-9;
 
-		if (strcmp(utmp,"E")==0) break;
-		else if (strstr(utmp,"LOAD(")==utmp) {
-			char d[1024],fn[500],b[500];
-			sprintf(d,"%s",&tmp[5]);
-			stripext(d);
-			sprintf(fn,"%s.par",d);
-			if (ljap->loadpar(fn) > 0) {
-				printf("Parameters loaded\n"); 
-				sprintf(fn,"%s.ljd",d);
-				// if not existent, no problem
-				if (ljap->loadexp(fn) > 0) printf("Lyapunov values loaded\n");
-				strcpy(ljap->fn,d);
-			} else { 
-				defect=1; 
-				printf("Error loading %s\n",fn);
-				ljap->fn[0]=0;
+			Bitmap bmp;
+			lj.createBmp(&bmp);
+			sprintf(fn,"_bench_%s.bmp",BENCHTEMPLATES[k]);
+			const int64_t ts=nanosec();
+			bmp.save(fn);
+			lj.phasens[PHASE_SAVE]=nanosec()-ts;
+			sprintf(fn,"_bench_%s.ljd",BENCHTEMPLATES[k]);
+			lj.saveexp(fn);
+
+			// accuracy against the reference
+			double maxerr=0,sumerr=0;
+			int32_t anzerr=0,anzfarbe=0;
+			for(int32_t i=0;i<anz;i++) {
+				const double a=lj.exps[i],b=ref[i];
+				int32_t r1=0,g1=0,b1=0,r2=0,g2=0,b2=0;
+				lj.farbe->farbe(a,r1,g1,b1);
+				lj.farbe->farbe(b,r2,g2,b2);
+				if ((r1!=r2)||(g1!=g2)||(b1!=b2)) anzfarbe++;
+				if ((a!=a)||(b!=b)) continue; // NaN
+				const double d=fabs(a-b);
+				if (d>maxerr) maxerr=d;
+				sumerr += d;
+				anzerr++;
 			}
-		} else if (strstr(utmp,"LOADCOLOR(")==utmp) {
-			char fn[1024];
-			if (strstr(utmp,".PAR")==NULL) {
-				sprintf(fn,"%s.par",&utmp[10]);
-			} else strcpy(fn,&utmp[10]);
+			const double meanerr=(anzerr>0) ? sumerr/anzerr : 0;
+			const double farbanteil=(double)anzfarbe/anz;
+			const double rate=(wall>0) ? mpixit/wall : 0;
+
+			printf("%-12s %2i %7i %10.2lf %10.3lf %8.3lf %9.3lf %6.3lf %9.2le %9.2le %14.5lf\n",
+				BENCHTEMPLATES[k],lj.fkt->id,t,rate,
+				lj.phasens[PHASE_TRANSIENT]*1E-9,lj.phasens[PHASE_COMPUTE]*1E-9,
+				lj.phasens[PHASE_COLORING]*1E-9,lj.phasens[PHASE_SAVE]*1E-9,
+				maxerr,meanerr,farbanteil);
+
+			if (!erster) fprintf(fj,",\n");
+			erster=0;
+			fprintf(fj,"{\"template\": \"%s\", \"id\": %i, \"threads\": %i, \"lenx\": %i, \"leny\": %i, \"iter0\": %i, \"iter1\": %i, ",
+				BENCHTEMPLATES[k],lj.fkt->id,t,lj.lenx,lj.leny,lj.iter0,lj.iter1);
+			fprintf(fj,"\"wall_s\": %.6lf, \"mpixel_iterations_per_s\": %.4lf, ",wall,rate);
+			fprintf(fj,"\"transient_s\": %.6lf, \"compute_s\": %.6lf, \"coloring_s\": %.6lf, \"save_s\": %.6lf, ",
+				lj.phasens[PHASE_TRANSIENT]*1E-9,lj.phasens[PHASE_COMPUTE]*1E-9,
+				lj.phasens[PHASE_COLORING]*1E-9,lj.phasens[PHASE_SAVE]*1E-9);
+			fprintf(fj,"\"max_error\": %.6le, \"mean_error\": %.6le, \"color_changed\": %.6lf, ",maxerr,meanerr,farbanteil);
+			fprintf(fj,"\"reference_changed\": %i, \"reference_max_error\": %.6le}",refanders,refmaxerr);
+		} // t
+
+		if (refanders>0) printf("%-12s CHANGED: %i of %i pixels differ from %s/%s.ljd, max %.2le\n",
+			BENCHTEMPLATES[k],refanders,BENCHREFLEN*BENCHREFLEN,BENCHREFDIR,BENCHTEMPLATES[k],refmaxerr);
+		else if (refanders==0) printf("%-12s identical to %s/%s.ljd\n",BENCHTEMPLATES[k],BENCHREFDIR,BENCHTEMPLATES[k]);
+
+		delete[] ref;
+	} // k
+
+	fprintf(fj,"\n]\n}\n");
+	fclose(fj);
+	cachemax=siccachemax;
+	printf("Results written to %s\n",fnjson);
+}
+
+
+// batch mode
+
+int32_t batchParSize(const char* fn,int32_t& x,int32_t& y) {
+	// LENX, LENY of a parameter file without loading it
+	FILE *f=fopen(fn,"rt");
+	if (!f) return 0;
+	char puffer[1000];
+	while (fgets(puffer,1000,f)) {
+		chomp(puffer); upper(puffer);
+		if (strcmp(puffer,"LENX")==0) fscanf(f,"%i\n",&x);
+		else if (strcmp(puffer,"LENY")==0) fscanf(f,"%i\n",&y);
+	}
+	fclose(f);
+	return 1;
+}
 
-			if (ljap->loadcolor(fn) <= 0) defect=1;
-		} else if (strstr(utmp,"WALKSEQ(")==utmp) {
-			int32_t anz,slen;
-			
-			if (sscanf(&utmp[8],"%i,%i",&anz,&slen) != 2) { 
-				printf("Error\n");
-				continue; 
+int32_t batchOverrides(Ljapunow* lj,char* ovr,const int32_t nurgroesse,int32_t& x,int32_t& y) {
+	// key=value words after par and output name:
+	// size=W,H iter=I0,I1 seq=AB.. threads=n precision=n
+	// nurgroesse: only evaluate size (memory estimate before loading)
+	char tmp[MAXBATCHLINE];
+	strcpy(tmp,ovr);
+	for(char* w=strtok(tmp," \t");w;w=strtok(NULL," \t")) {
+		int32_t a,b;
+		if (strstr(w,"size=")==w) {
+			if (sscanf(&w[5],"%i,%i",&a,&b) != 2) return 0;
+			x=a; y=b;
+		} else if (nurgroesse) continue;
+		else if (strstr(w,"iter=")==w) {
+			if (sscanf(&w[5],"%i,%i",&a,&b) != 2) return 0;
+			lj->setiter(a,b);
+		} else if (strstr(w,"seq=")==w) {
+			lj->setSequence(&w[4]);
+			if (lj->seqlen<=0) return 0;
+		} else if (strstr(w,"threads=")==w) {
+			if (sscanf(&w[8],"%i",&a) != 1) return 0;
+			lj->setthreads(a);
+		} else if (strstr(w,"precision=")==w) {
+			if (sscanf(&w[10],"%i",&a) != 1) return 0;
+			lj->setprecision(a);
+		} else return 0;
+	}
+	return 1;
+}
+
+double estimateJob(const char* par,char* ovr) {
+	// single threaded seconds of a batch or daemon job, -1: none.
+	// Large images are sampled scaled down, the cost per pixel stays
+	Ljapunow* lj=new Ljapunow;
+	lj->quiet=1;
+	lj->setthreads(1);
+	double sek=-1;
+	int32_t x=0,y=0;
+	if (lj->loadpar((char*)par) > 0) {
+		x=lj->lenx; y=lj->leny;
+		if (batchOverrides(lj,ovr,0,x,y) > 0) {
+			lj->setthreads(1);
+			int32_t sx=x,sy=y;
+			while ((sx>ESTMAXLEN)||(sy>ESTMAXLEN)) { sx >>= 1; sy >>= 1; }
+			if ((sx!=lj->lenx)||(sy!=lj->leny)) lj->setlen(sx,sy);
+			int64_t mem,ausgabe;
+			sek=lj->estimate(mem,ausgabe,0);
+			if ((sek>0)&&(lj->lenx>0)&&(lj->leny>0)) sek *= ((double)x*y)/((double)lj->lenx*lj->leny);
+		}
+	}
+	delete lj;
+	return sek;
+}
+
+int32_t batchSchaetzungCmp(const void* a,const void* b) {
+	// longest first, unknown last, else manifest order
+	const BatchJob* ja=(const BatchJob*)a;
+	const BatchJob* jb=(const BatchJob*)b;
+	if (ja->schaetzung!=jb->schaetzung) return (ja->schaetzung>jb->schaetzung) ? -1 : 1;
+	return (ja->nr<jb->nr) ? -1 : 1;
+}
+
+void runBatchJob(BatchQueue* q,BatchJob* job) {
+	job->ok=0;
+	int32_t x=0,y=0;
+	if (batchParSize(job->par,x,y) <= 0) { snprintf(job->fehler,sizeof(job->fehler),"cannot read %.200s",job->par); return; }
+	if (batchOverrides(NULL,job->ovr,1,x,y) <= 0) { snprintf(job->fehler,sizeof(job->fehler),"bad override"); return; }
+	// exponents, bitmap, some slack for the rest
+	job->mem=(int64_t)x*y*(sizeof(double)+3)+(1 << 20);
+	if (job->mem > q->memlimit) { snprintf(job->fehler,sizeof(job->fehler),"needs %lli MB, limit %lli MB",(long long)(job->mem >> 20),(long long)(q->memlimit >> 20)); return; }
+
+	int64_t t0=nanosec();
+	{
+		std::unique_lock<std::mutex> lock(q->m);
+		while (job->mem > q->memfrei) q->cv.wait(lock);
+		q->memfrei -= job->mem;
+	}
+	int64_t t1=nanosec();
+	job->nswait=t1-t0;
+
+	// the threads of the runners are shared: a job gets an equal part
+	// of the free ones among itself and the jobs not yet started, so
+	// the last jobs use the threads of the runners that ran out of work
+	int32_t anteil;
+	{
+		std::lock_guard<std::mutex> lock(q->m);
+		const int32_t wartend=maximumI(q->anz-q->next,0);
+		anteil=maximumI(q->threadsfrei/(wartend+1),1);
+		q->threadsfrei -= anteil;
+	}
+
+	Ljapunow* lj=new Ljapunow;
+	lj->quiet=1;
+	lj->setthreads(anteil);
+	if (lj->loadpar(job->par) <= 0) snprintf(job->fehler,sizeof(job->fehler),"error loading %.200s",job->par);
+	else if (batchOverrides(lj,job->ovr,0,x,y) <= 0) snprintf(job->fehler,sizeof(job->fehler),"bad override");
+	else {
+		if ((x!=lj->lenx)||(y!=lj->leny)) lj->setlen(x,y);
+		int64_t t2=nanosec();
+		job->nsload=t2-t1;
+		lj->calc(0,lj->leny-1);
+		int64_t t3=nanosec();
+		job->nscalc=t3-t2;
+		char fn[1100];
+		sprintf(fn,"%s.bmp",job->out); lj->savebmp(fn,NULL);
+		sprintf(fn,"%s.par",job->out); lj->savepar(fn);
+		sprintf(fn,"%s.ljd",job->out); lj->saveexp(fn);
+		job->nssave=nanosec()-t3;
+		job->ok=1;
+	}
+	job->threads=lj->threads; // threads= overrides the part
+	delete lj;
+
+	{
+		std::lock_guard<std::mutex> lock(q->m);
+		q->memfrei += job->mem;
+		q->threadsfrei += anteil;
+	}
+	q->cv.notify_all();
+}
+
+void batchRunner(BatchQueue* q,const int32_t nr) {
+	while (1) {
+		const int32_t i=q->next.fetch_add(1);
+		if (i>=q->anz) break;
+		q->jobs[i].runner=nr;
+		runBatchJob(q,&q->jobs[i]);
+		BatchJob& j=q->jobs[i];
+		if (j.ok) printf("job %i %s ok: wait %.3lf load %.3lf calc %.3lf save %.3lf sec\n",
+			j.nr,j.out,j.nswait*1E-9,j.nsload*1E-9,j.nscalc*1E-9,j.nssave*1E-9);
+		else printf("job %i %s FAILED: %s\n",j.nr,j.out,j.fehler);
+	}
+}
+
+int32_t runBatch(const char* fnmanifest,const int32_t anzrunner,const int32_t memmb,const char* fnjson,const int32_t ordnung) {
+	// manifest: one job per line "parfile outputname [overrides]",
+	// # comments. ordnung: jobs run longest estimated first instead of
+	// in manifest order. Returns the exit status: 0 all jobs ok, 1 some
+	// failed, 2 manifest not readable
+	FILE *f=fopen(fnmanifest,"rt");
+	if (!f) { printf("Error opening %s\n",fnmanifest); return 2; }
+	int32_t anz=0;
+	char zeile[MAXBATCHLINE];
+	while (fgets(zeile,MAXBATCHLINE,f)) {
+		chomp(zeile);
+		if ((zeile[0]!='#')&&(zeile[0]>' ')) anz++;
+	}
+	if (anz<=0) { fclose(f); printf("No jobs in %s\n",fnmanifest); return 2; }
+
+	BatchQueue q;
+	q.jobs=new BatchJob[anz];
+	q.anz=0;
+	q.next=0;
+	q.memlimit=q.memfrei=(int64_t)memmb << 20;
+	rewind(f);
+	while ((q.anz<anz)&&(fgets(zeile,MAXBATCHLINE,f))) {
+		chomp(zeile);
+		if ((zeile[0]=='#')||(zeile[0]<=' ')) continue;
+		BatchJob& j=q.jobs[q.anz];
+		memset(&j,0,sizeof(j));
+		j.nr=++q.anz;
+		int32_t pos=0;
+		if (sscanf(zeile,"%1000s %1000s%n",j.par,j.out,&pos) < 2) strcpy(j.out,"_batch");
+		else strcpy(j.ovr,&zeile[pos]);
+		j.schaetzung=-1;
+	}
+	fclose(f);
+
+	if (ordnung) {
+		int64_t t0=nanosec();
+		for(int32_t i=0;i<q.anz;i++) q.jobs[i].schaetzung=estimateJob(q.jobs[i].par,q.jobs[i].ovr);
+		qsort(q.jobs,q.anz,sizeof(BatchJob),batchSchaetzungCmp);
+		printf("jobs ordered by estimate in %.3lf sec, longest %.1lf sec\n",(nanosec()-t0)*1E-9,q.jobs[0].schaetzung);
+	}
+
+	int32_t anzt=minimumI((anzrunner<1) ? 1 : anzrunner,q.anz);
+	if (anzt>MAXTHREADS) anzt=MAXTHREADS;
+	q.threadsfrei=minimumI((anzrunner<1) ? 1 : anzrunner,MAXTHREADS);
+	printf("%i jobs, %i at a time, memory limit %i MB\n",q.anz,anzt,memmb);
+	int64_t t0=nanosec();
+	std::thread* th[MAXTHREADS];
+	for(int32_t i=0;i<anzt;i++) th[i]=new std::thread(batchRunner,&q,i);
+	for(int32_t i=0;i<anzt;i++) { th[i]->join(); delete th[i]; }
+	const double wall=(nanosec()-t0)*1E-9;
+
+	int32_t anzfehler=0;
+	for(int32_t i=0;i<q.anz;i++) if (!q.jobs[i].ok) anzfehler++;
+	printf("%i of %i jobs ok in %.3lf sec\n",q.anz-anzfehler,q.anz,wall);
+
+	FILE *fj=fopen(fnjson,"wt");
+	if (fj) {
+		fprintf(fj,"{\n\"manifest\": ");
+		writejson(fj,fnmanifest);
+		fprintf(fj,",\n\"runners\": %i,\n\"memory_limit_mb\": %i,\n\"wall_s\": %.6lf,\n\"failed\": %i,\n\"jobs\": [\n",
+			anzt,memmb,wall,anzfehler);
+		for(int32_t i=0;i<q.anz;i++) {
+			const BatchJob& j=q.jobs[i];
+			fprintf(fj,"{\"nr\": %i, \"par\": ",j.nr);
+			writejson(fj,j.par);
+			fprintf(fj,", \"out\": ");
+			writejson(fj,j.out);
+			fprintf(fj,", \"status\": \"%s\", \"error\": ",j.ok ? "ok" : "failed");
+			writejson(fj,j.fehler);
+			fprintf(fj,", \"runner\": %i, \"threads\": %i, \"memory_bytes\": %lli, ",j.runner,j.threads,(long long)j.mem);
+			fprintf(fj,"\"estimate_s\": %.6lf, \"wait_s\": %.6lf, \"load_s\": %.6lf, \"calc_s\": %.6lf, \"save_s\": %.6lf}%s\n",
+				j.schaetzung,j.nswait*1E-9,j.nsload*1E-9,j.nscalc*1E-9,j.nssave*1E-9,(i+1<q.anz) ? "," : "");
+		}
+		fprintf(fj,"]\n}\n");
+		fclose(fj);
+	}
+	delete[] q.jobs;
+
+	return (anzfehler>0) ? 1 : 0;
+}
+
+
+// guided search
+
+// functions METADET may combine in the search
+const int32_t SUCHFKTIDS[]={
+	ID_FKT_I,ID_FKT_II,ID_FKT_SICO,ID_FKT_III,ID_FKT_VII,
+	ID_FKT_IX,ID_FKT_X,ID_FKT_LSIN,ID_FKT_ATAN
+};
+const int32_t ANZSUCHFKTIDS=sizeof(SUCHFKTIDS)/sizeof(SUCHFKTIDS[0]);
+
+uint64_t suchZufall(uint64_t& z) {
+	// xorshift64, the generator of a generation is seeded from the
+	// journal seed so a resumed search continues the same way
+	z ^= z << 13;
+	z ^= z >> 7;
+	z ^= z << 17;
+	return z;
+}
+
+double suchGleich(uint64_t& z) {
+	// uniform in [0..1)
+	return (suchZufall(z) >> 11)*(1.0/9007199254740992.0);
+}
+
+double suchNormal(uint64_t& z) {
+	const double u=suchGleich(z)+1E-300;
+	return sqrt(-2.0*log(u))*cos(2.0*M_PI*suchGleich(z));
+}
+
+double suchStartB(Function* f) {
+	if (!f) return 0;
+	if (f->id==ID_FKT_I) return 0;
+	if (f->id==ID_FKT_METADET) return suchStartB(((FunctionMetaDet*)f)->f);
+	if (f->id==ID_FKT_METAABSC) return suchStartB(((FunctionMetaABSC*)f)->fint);
+	return ((FunctionII*)f)->b;
+}
+
+void suchAnwenden(Ljapunow* lj,const SuchKandidat& k) {
+	char seq[MAXSUCHSEQ+1];
+	strcpy(seq,k.seq);
+	lj->setSequence(seq);
+	if (lj->fkt->id==ID_FKT_METADET) {
+		FunctionMetaDet* m=(FunctionMetaDet*)lj->fkt;
+		if ((!m->f)||(m->f->id!=k.fid)) { if (m->f) delete m->f; m->f=getNewFunction(k.fid); }
+		if ((!m->abl)||(m->abl->id!=k.ablid)) { if (m->abl) delete m->abl; m->abl=getNewFunction(k.ablid); }
+	} else if (lj->fkt->id==ID_FKT_METAABSC) {
+		((FunctionMetaABSC*)lj->fkt)->setsections(k.sec[0],k.sec[1],k.sec[2],k.sec[3]);
+	}
+	if (lj->fkt->id!=ID_FKT_I) lj->fkt->set_b(k.b);
+}
+
+int32_t suchGleicheKandidaten(const SuchKandidat& a,const SuchKandidat& c) {
+	if ((a.b!=c.b)||(strcmp(a.seq,c.seq))||(a.fid!=c.fid)||(a.ablid!=c.ablid)) return 0;
+	for(int32_t i=0;i<4;i++) if (a.sec[i]!=c.sec[i]) return 0;
+	return 1;
+}
+
+void suchMutation(SuchKandidat& k,const SuchKandidat& elter,const int32_t fktid,uint64_t& z) {
+	// changes at least one dimension the current function has
+	k=elter;
+	int32_t geaendert=0;
+	while (!geaendert) {
+		if ((fktid!=ID_FKT_I)&&(suchGleich(z)<0.5)) {
+			k.b += suchNormal(z)*0.05*(fabs(k.b)+0.1);
+			geaendert=1;
+		}
+		if (suchGleich(z)<0.5) {
+			int32_t len=strlen(k.seq);
+			const double w=suchGleich(z);
+			if ((w<0.15)&&(len<MAXSUCHSEQ)) { k.seq[len]='A'+(suchZufall(z) & 1); k.seq[++len]=0; }
+			else if ((w<0.3)&&(len>2)) k.seq[--len]=0;
+			else {
+				const int32_t i=suchZufall(z) % len;
+				k.seq[i]=(k.seq[i]=='A') ? 'B' : 'A';
+			}
+			geaendert=1;
+		}
+		if ((fktid==ID_FKT_METAABSC)&&(suchGleich(z)<0.5)) {
+			for(int32_t i=0;i<4;i++) {
+				k.sec[i] += 0.1*suchNormal(z);
+				if (k.sec[i]<-1.0) k.sec[i]=-1.0;
+				if (k.sec[i]>1.0) k.sec[i]=1.0;
 			}
+			for(int32_t i=0;i<4;i+=2) if (k.sec[i]>k.sec[i+1]) {
+				const double h=k.sec[i]; k.sec[i]=k.sec[i+1]; k.sec[i+1]=h;
+			}
+			geaendert=1;
+		}
+		if ((fktid==ID_FKT_METADET)&&(suchGleich(z)<0.3)) {
+			const int32_t id=SUCHFKTIDS[suchZufall(z) % ANZSUCHFKTIDS];
+			if (suchZufall(z) & 1) k.fid=id; else k.ablid=id;
+			geaendert=1;
+		}
+	}
+}
 
-			char ts[500];
-			if (slen>64) slen=64;
-			ts[slen]=0;
-			
-			for(int n=0;n<anz;n++) {
-				for(int32_t i=0;i<slen;i++) ts[i]='A'+rand()%2;
-				ljap->setSequence(ts);
-				printf("%s ",ts);
-				ljap->calc(0,ljap->leny-1);
-
-				char fn[1024],orig[1024];
-				sprintf(orig,"_walkseq_%04i_%s",n+1,ts); 
-				sprintf(fn,"%s.bmp",orig);
-				ljap->savebmp(fn,NULL);
-				sprintf(fn,"%s.par",orig);
-				ljap->savepar(fn);
-				sprintf(fn,"%s.ljd",orig);
-				ljap->saveexp(fn);
-			} // n
-		} else if (strstr(utmp,"SETSIZE(")==utmp) {
-			int32_t xl,yl;
-			if (sscanf(&utmp[8],"%i,%i",&xl,&yl) != 2) { printf("Error\n");continue; }
-			ljap->setlen(xl,yl);
-		} else if (strstr(utmp,"SETITER(")==utmp) {
-			int32_t a,b;
-			if (sscanf(&utmp[8],"%i,%i",&a,&b) != 2) { printf("Error\n");continue; }
-			ljap->setiter(a,b);
-		} else if (strstr(utmp,"ROTATEDEG(")==utmp) {
-			int32_t w;
-			if (sscanf(&utmp[10],"%i",&w) != 1) { printf("Error\n"); continue; }
-			ljap->rot(w);
-		} else if (strstr(utmp,"STRETCH(")==utmp) {
-			double fx;
-			if (sscanf(&tmp[8],"%le",&fx) != 1) { printf("Error\n");continue; }
-			ljap->stretch(fx,fx);
-		} else if (strstr(utmp,"SETSEQUENCE(")==utmp) {
-			ljap->setSequence(&utmp[12]);
-		} else if (strstr(utmp,"SETPOSITION(")==utmp) {
-			double a,b,c,d,e,f;
+int32_t suchKandidatCmp(const void* a,const void* b) {
+	// descending by score, NaN last, ties in journal order
+	const SuchKandidat* ka=(const SuchKandidat*)a;
+	const SuchKandidat* kb=(const SuchKandidat*)b;
+	const double sa=(ka->score==ka->score) ? ka->score : -1;
+	const double sb=(kb->score==kb->score) ? kb->score : -1;
+	if (sa!=sb) return (sa>sb) ? -1 : 1;
+	if (ka->gen!=kb->gen) return (ka->gen<kb->gen) ? -1 : 1;
+	return (ka->nr<kb->nr) ? -1 : ((ka->nr>kb->nr) ? 1 : 0);
+}
+
+void suchWorker(SuchArbeit* a,const int32_t nr) {
+	tracetid=tracetidnext.fetch_add(1);
+	while (1) {
+		const int32_t i=a->next.fetch_add(1);
+		if (i>=a->anz) break;
+		TraceSpan span("candidate",i);
+		SuchKandidat& k=a->k[i];
+		Ljapunow* lj=a->lj[nr];
+		suchAnwenden(lj,k);
+		double e,kn,fl;
+		if ((lj->seqlen>0)&&(lj->calc(0,lj->leny-1)>0)) k.score=lj->gatescore(e,kn,fl);
+		else k.score=0;
+	}
+	tracetid=0;
+}
+
+void suchJournalZeile(FILE* f,const SuchKandidat& k) {
+	fprintf(f,"C %i %i %.17lg %.17lg %s %i %i %.17lg %.17lg %.17lg %.17lg\n",
+		k.gen,k.nr,k.score,k.b,k.seq,k.fid,k.ablid,k.sec[0],k.sec[1],k.sec[2],k.sec[3]);
+}
+
+int32_t suchJournalLesen(const char* fn,const uint64_t key,const int32_t pop,uint64_t& seed,SuchKandidat* alle,const int32_t maxanz) {
+	// candidates of the complete generations of a journal of the same
+	// search, returns their number
+	FILE *f=fopen(fn,"rt");
+	if (!f) return 0;
+	unsigned long long k=0,sd=0;
+	int32_t p=0,anz=0;
+	char zeile[1024];
+	if (
+		(!fgets(zeile,1024,f)) ||
+		(sscanf(zeile,"SEARCH %llx %llx %i",&k,&sd,&p) != 3) ||
+		(k!=key) || (p!=pop)
+	) {
+		fclose(f);
+		printf("%s belongs to another search, starting anew\n",fn);
+		return 0;
+	}
+	while ((anz<maxanz)&&(fgets(zeile,1024,f))) {
+		SuchKandidat& c=alle[anz];
+		memset(&c,0,sizeof(c));
+		if (sscanf(zeile,"C %i %i %lg %lg %16s %i %i %lg %lg %lg %lg",
+			&c.gen,&c.nr,&c.score,&c.b,c.seq,&c.fid,&c.ablid,&c.sec[0],&c.sec[1],&c.sec[2],&c.sec[3]) != 11) break;
+		// generations are written whole and in order
+		if ((c.gen != anz/pop)||(c.nr != anz%pop)) break;
+		anz++;
+	}
+	fclose(f);
+	seed=sd;
+	return anz-(anz % pop);
+}
+
+void runSearch(Ljapunow* ljap,const int32_t gens,const int32_t pop,const int32_t topk,const char* fnjournal) {
+	// (mu+lambda) evolution over b, sequence, METAABSC sections and
+	// METADET function pairs. Every generation of pop candidates is
+	// computed as thumbnails in parallel and scored like GATE, parents
+	// are drawn by tournament from the best pop found so far. The
+	// journal holds every scored candidate, an interrupted search with
+	// the same parameters continues after its last whole generation
+	if ((!ljap->fkt)||(!ljap->farbe)||(ljap->seqlen<=0)||(gens<1)||(pop<2)) { printf("Nothing to search\n"); return; }
+	if (ljap->seqlen>MAXSUCHSEQ) { printf("Sequence longer than %i\n",MAXSUCHSEQ); return; }
+
+	int32_t keylen;
+	char* key=ljap->cachekey(keylen);
+	const uint64_t keyh=fnv1a(key,keylen,0);
+	delete[] key;
+	ljap->savepar((char*)SUCHPAR);
+
+	SuchKandidat* alle=new SuchKandidat[gens*pop];
+	SuchKandidat* pool=new SuchKandidat[gens*pop];
+	uint64_t seed=((uint64_t)time(NULL) << 20) ^ (uint64_t)nanosec() ^ keyh;
+	int32_t anz=suchJournalLesen(fnjournal,keyh,pop,seed,alle,gens*pop);
+	if (seed==0) seed=1;
+	if (anz>0) printf("resuming after generation %i\n",anz/pop);
+
+	// the journal is rewritten from its whole generations
+	FILE *fj=fopen(fnjournal,"wt");
+	if (!fj) { printf("Error writing %s\n",fnjournal); delete[] alle; delete[] pool; return; }
+	fprintf(fj,"SEARCH %016llx %016llx %i\n",(unsigned long long)keyh,(unsigned long long)seed,pop);
+	for(int32_t i=0;i<anz;i++) suchJournalZeile(fj,alle[i]);
+	fflush(fj);
+
+	SuchKandidat start;
+	memset(&start,0,sizeof(start));
+	start.b=suchStartB(ljap->fkt);
+	ljap->getSequence(start.seq);
+	const int32_t fktid=ljap->fkt->id;
+	start.fid=start.ablid=-1;
+	if (fktid==ID_FKT_METADET) {
+		FunctionMetaDet* m=(FunctionMetaDet*)ljap->fkt;
+		start.fid=(m->f) ? m->f->id : ID_FKT_II;
+		start.ablid=(m->abl) ? m->abl->id : ID_FKT_II;
+	} else if (fktid==ID_FKT_METAABSC) {
+		FunctionMetaABSC* m=(FunctionMetaABSC*)ljap->fkt;
+		start.sec[0]=m->I0MIN; start.sec[1]=m->I0MAX;
+		start.sec[2]=m->I1MIN; start.sec[3]=m->I1MAX;
+	}
+
+	// thumbnails as in GATE, one calculating copy per worker
+	const int32_t div=(ljap->gatediv>1) ? ljap->gatediv : GATEDIV;
+	const int32_t anzt=minimumI(minimumI(ljap->threads,pop),MAXTHREADS);
+	Ljapunow* lj[MAXTHREADS];
+	for(int32_t t=0;t<anzt;t++) {
+		lj[t]=new Ljapunow;
+		lj[t]->quiet=1;
+		lj[t]->setthreads(1);
+		lj[t]->loadpar((char*)SUCHPAR);
+		lj[t]->setprecision(ljap->precision);
+		lj[t]->setlen(
+			(ljap->lenx/div)>GATEMINLEN ? ljap->lenx/div : GATEMINLEN,
+			(ljap->leny/div)>GATEMINLEN ? ljap->leny/div : GATEMINLEN
+		);
+		lj[t]->setiter(
+			(ljap->iter0/div)>2 ? ljap->iter0/div : 2,
+			(ljap->iter1/div)>2 ? ljap->iter1/div : 2
+		);
+	}
+
+	int64_t t0=nanosec();
+	for(int32_t g=anz/pop;g<gens;g++) {
+		TraceSpan span("generation",g);
+		uint64_t z=seed ^ (0x9E3779B97F4A7C15ULL*(uint64_t)(g+1));
+		if (z==0) z=1;
+		SuchKandidat* k=&alle[anz];
+		// parents: best pop of all scored so far
+		int32_t anzpool=minimumI(anz,pop);
+		if (anz>0) {
+			memcpy(pool,alle,anz*sizeof(SuchKandidat));
+			qsort(pool,anz,sizeof(SuchKandidat),suchKandidatCmp);
+		}
+		for(int32_t i=0;i<pop;i++) {
+			if (anzpool<=0) {
+				if (i==0) k[i]=start; else suchMutation(k[i],start,fktid,z);
+			} else {
+				const int32_t a=suchZufall(z) % anzpool;
+				const int32_t c=suchZufall(z) % anzpool;
+				suchMutation(k[i],pool[minimumI(a,c)],fktid,z);
+			}
+			k[i].gen=g;
+			k[i].nr=i;
+			k[i].score=0;
+		}
+
+		SuchArbeit arbeit;
+		arbeit.lj=lj;
+		arbeit.k=k;
+		arbeit.anz=pop;
+		arbeit.next=0;
+		if (anzt<=1) suchWorker(&arbeit,0);
+		else {
+			std::thread* th[MAXTHREADS];
+			for(int32_t t=0;t<anzt;t++) th[t]=new std::thread(suchWorker,&arbeit,t);
+			for(int32_t t=0;t<anzt;t++) { th[t]->join(); delete th[t]; }
+		}
+
+		double best=0;
+		int32_t ib=0;
+		for(int32_t i=0;i<pop;i++) {
+			suchJournalZeile(fj,k[i]);
+			if (k[i].score>best) { best=k[i].score; ib=i; }
+		}
+		fflush(fj);
+		anz += pop;
+		printf("generation %i: best %.4lf (b=%.6lf %s) %.3lf sec\n",g,best,k[ib].b,k[ib].seq,(nanosec()-t0)*1E-9);
+	}
+	fclose(fj);
+	for(int32_t t=0;t<anzt;t++) delete lj[t];
+
+	// the best distinct candidates at full size
+	memcpy(pool,alle,anz*sizeof(SuchKandidat));
+	qsort(pool,anz,sizeof(SuchKandidat),suchKandidatCmp);
+	Ljapunow* voll=new Ljapunow;
+	voll->loadpar((char*)SUCHPAR);
+	voll->setthreads(ljap->threads);
+	voll->setprecision(ljap->precision);
+	int32_t n=0;
+	for(int32_t i=0;(i<anz)&&(n<topk);i++) {
+		int32_t doppelt=0;
+		for(int32_t j=0;j<i;j++) if (suchGleicheKandidaten(pool[i],pool[j])) { doppelt=1; break; }
+		if (doppelt) continue;
+		n++;
+		printf("top %i: score %.4lf b=%.10lf %s",n,pool[i].score,pool[i].b,pool[i].seq);
+		if (fktid==ID_FKT_METADET) printf(" f %i g %i",pool[i].fid,pool[i].ablid);
+		if (fktid==ID_FKT_METAABSC) printf(" sections %.3lf %.3lf %.3lf %.3lf",pool[i].sec[0],pool[i].sec[1],pool[i].sec[2],pool[i].sec[3]);
+		printf("\n");
+		suchAnwenden(voll,pool[i]);
+		voll->calc(0,voll->leny-1);
+		char fn[1024];
+		sprintf(fn,"_search%02i.bmp",n); voll->savebmp(fn,NULL);
+		sprintf(fn,"_search%02i.par",n); voll->savepar(fn);
+		sprintf(fn,"_search%02i.ljd",n); voll->saveexp(fn);
+	}
+	delete voll;
+	delete[] alle;
+	delete[] pool;
+}
+
+
+// result cache
+
+uint64_t fnv1a(const void* p,const int64_t n,uint64_t h) {
+	// FNV-1a 64 bit, h=0: start value
+	if (h==0) h=14695981039346656037ULL;
+	const uint8_t* q=(const uint8_t*)p;
+	for(int64_t i=0;i<n;i++) {
+		h ^= q[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+struct CacheEintrag {
+	char fn[1200];
+	int64_t bytes;
+	time_t zeit;
+};
+
+int32_t cacheEintragCmp(const void* a,const void* b) {
+	const time_t za=((const CacheEintrag*)a)->zeit;
+	const time_t zb=((const CacheEintrag*)b)->zeit;
+	return (za<zb) ? -1 : ((za>zb) ? 1 : 0);
+}
+
+void cacheEvict(void) {
+	// least recently used entries go until the cache fits cachemax
+	#ifdef __linux__
+	DIR* d=opendir(cachedir);
+	if (!d) return;
+	int32_t anz=0,kap=64;
+	CacheEintrag* e=new CacheEintrag[kap];
+	int64_t summe=0;
+	struct dirent* de;
+	while ((de=readdir(d))!=NULL) {
+		const int32_t l=strlen(de->d_name);
+		if ((l<4)||(strcmp(&de->d_name[l-4],".ljc")!=0)) continue;
+		if (anz>=kap) {
+			CacheEintrag* neu=new CacheEintrag[2*kap];
+			memcpy(neu,e,kap*sizeof(CacheEintrag));
+			delete[] e;
+			e=neu;
+			kap *= 2;
+		}
+		snprintf(e[anz].fn,1200,"%s/%s",cachedir,de->d_name);
+		struct stat st;
+		if (stat(e[anz].fn,&st)!=0) continue;
+		e[anz].bytes=st.st_size;
+		e[anz].zeit=st.st_mtime;
+		summe += st.st_size;
+		anz++;
+	}
+	closedir(d);
+
+	if (summe > cachemax) {
+		qsort(e,anz,sizeof(CacheEintrag),cacheEintragCmp);
+		for(int32_t i=0;(i<anz)&&(summe>cachemax);i++) {
+			if (remove(e[i].fn)==0) summe -= e[i].bytes;
+		}
+	}
+	delete[] e;
+	#endif
+}
+
+void setCache(const int32_t mb,const char* dir) {
+	// mb=0 switches the cache off
+	cachemax=(int64_t)mb << 20;
+	strcpy(cachedir,(dir) ? dir : CACHEDIR);
+	if (cachemax<=0) return;
+	#ifdef __linux__
+	mkdir(cachedir,0755);
+	#else
+	char tmp[1100];
+	sprintf(tmp,"mkdir %s 2>nul",cachedir);
+	system(tmp);
+	#endif
+	cacheEvict();
+}
+
+
+// render daemon
+
+DaemonJob* Daemon::naechster(void) {
+	// highest priority first, in order of arrival (ordnung: of the
+	// estimated time) within a priority
+	DaemonJob* erg=NULL;
+	for(int32_t i=0;i<anz;i++) {
+		if (jobs[i].zustand!=DJOB_QUEUED) continue;
+		if ((!erg)||(jobs[i].prio > erg->prio)) erg=&jobs[i];
+		else if (jobs[i].prio==erg->prio) {
+			if ((ordnung)&&(jobs[i].schaetzung>=0)&&(jobs[i].schaetzung!=erg->schaetzung)) {
+				if (jobs[i].schaetzung < erg->schaetzung) erg=&jobs[i];
+			} else if (jobs[i].id < erg->id) erg=&jobs[i];
+		}
+	}
+	return erg;
+}
+
+DaemonJob* Daemon::suche(const int32_t id) {
+	if (id<1) return NULL;
+	for(int32_t i=0;i<anz;i++) if (jobs[i].id==id) return &jobs[i];
+	return NULL;
+}
+
+DaemonJob* Daemon::neu(void) {
+	// an unused slot while there is one, else the oldest finished job
+	// whose exponents are not waiting for FETCH and no one WAITs for
+	if (anz<MAXDAEMONJOBS) return &jobs[anz++];
+	DaemonJob* erg=NULL;
+	for(int32_t i=0;i<anz;i++) {
+		DaemonJob& j=jobs[i];
+		if ((j.zustand==DJOB_QUEUED)||(j.zustand==DJOB_RUNNING)) continue;
+		if ((j.erg)||(j.warten>0)) continue;
+		if ((!erg)||(j.id < erg->id)) erg=&j;
+	}
+	return erg;
+}
+
+void daemonRunner(Daemon* d) {
+	Ljapunow* lj=new Ljapunow;
+	Bitmap bmp;
+	lj->quiet=1;
+
+	while (1) {
+		DaemonJob* j=NULL;
+		{
+			std::unique_lock<std::mutex> lock(d->m);
+			while ((!d->ende)&&((j=d->naechster())==NULL)) d->cv.wait(lock);
+			if (!j) break;
+			j->zustand=DJOB_RUNNING;
+			j->lj=lj;
+			lj->abbruch=0;
+		}
+
+		int32_t x=0,y=0,zustand=DJOB_FAILED;
+		lj->setthreads(1);
+		if (lj->loadpar(j->par) <= 0) snprintf(j->fehler,sizeof(j->fehler),"error loading %.200s",j->par);
+		else {
+			x=lj->lenx; y=lj->leny;
+			if (batchOverrides(lj,j->ovr,0,x,y) <= 0) snprintf(j->fehler,sizeof(j->fehler),"bad override");
+			else {
+				if ((x!=lj->lenx)||(y!=lj->leny)) lj->setlen(x,y);
+				int64_t t0=nanosec();
+				if (lj->calc(0,lj->leny-1) <= 0) zustand=DJOB_CANCELLED;
+				else {
+					j->nscalc=nanosec()-t0;
+					if (strcmp(j->out,"-")==0) {
+						j->erg=new double[lj->lenx*lj->leny];
+						memcpy(j->erg,lj->exps,lj->lenx*lj->leny*sizeof(double));
+						j->ergx=lj->lenx;
+						j->ergy=lj->leny;
+					} else {
+						char fn[1100];
+						sprintf(fn,"%s.bmp",j->out); lj->savebmp(fn,&bmp);
+						sprintf(fn,"%s.par",j->out); lj->savepar(fn);
+						sprintf(fn,"%s.ljd",j->out); lj->saveexp(fn);
+					}
+					zustand=DJOB_DONE;
+				}
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(d->m);
+			j->lj=NULL;
+			j->zustand=zustand;
+		}
+		d->cv.notify_all();
+	}
+
+	delete lj;
+}
+
+#ifdef __linux__
+int32_t daemonSend(const int32_t fd,const void* p,const int32_t n) {
+	// no SIGPIPE if the client is gone
+	const char* q=(const char*)p;
+	int32_t rest=n;
+	while (rest>0) {
+		ssize_t w=send(fd,q,rest,MSG_NOSIGNAL);
+		if (w<=0) return 0;
+		q += w; rest -= w;
+	}
+	return 1;
+}
+
+int32_t daemonSendStr(const int32_t fd,const char* s) {
+	return daemonSend(fd,s,strlen(s));
+}
+
+char* daemonZustand(DaemonJob* j,char* s) {
+	switch (j->zustand) {
+		case DJOB_QUEUED: sprintf(s,"OK %i queued\n",j->id); break;
+		case DJOB_RUNNING: sprintf(s,"OK %i running\n",j->id); break;
+		case DJOB_DONE: sprintf(s,"OK %i done %.3lf\n",j->id,j->nscalc*1E-9); break;
+		case DJOB_CANCELLED: sprintf(s,"OK %i cancelled\n",j->id); break;
+		default: sprintf(s,"OK %i failed %s\n",j->id,j->fehler); break;
+	}
+	return s;
+}
+
+void daemonConnection(Daemon* d,const int32_t fd,const int32_t slot) {
+	// one line per request, one line per answer (FETCH: plus data)
+	FILE* f=fdopen(fd,"r");
+	if (!f) {
+		std::lock_guard<std::mutex> lock(d->m);
+		d->verbfd[slot]=-1;
+		::close(fd);
+		return;
+	}
+	char zeile[MAXBATCHLINE],cmd[MAXBATCHLINE],antwort[1200];
+
+	while (fgets(zeile,MAXBATCHLINE,f)) {
+		chomp(zeile);
+		int32_t id=0,pos=0;
+		cmd[0]=0;
+		sscanf(zeile,"%63s%n",cmd,&pos);
+		upper(cmd);
+
+		if (strcmp(cmd,"RENDER")==0) {
+			// RENDER prio parfile out [overrides]
+			int32_t prio,p2=0;
+			char par[1024],out[1024];
+			if (sscanf(&zeile[pos],"%i %1000s %1000s%n",&prio,par,out,&p2) < 3) {
+				daemonSendStr(fd,"ERROR parameters\n");
+				continue;
+			}
+			const double sek=(d->ordnung) ? estimateJob(par,&zeile[pos+p2]) : -1;
+			std::lock_guard<std::mutex> lock(d->m);
+			// the runners may have stopped, nobody would compute it
+			if (d->ende) { daemonSendStr(fd,"ERROR shutting down\n"); continue; }
+			DaemonJob* neu=d->neu();
+			if (!neu) { daemonSendStr(fd,"ERROR job table full\n"); continue; }
+			DaemonJob& j=*neu;
+			memset(&j,0,sizeof(j));
+			j.id=++d->letzteid;
+			j.prio=prio;
+			strcpy(j.par,par);
+			strcpy(j.out,out);
+			strcpy(j.ovr,&zeile[pos+p2]);
+			j.schaetzung=sek;
+			j.zustand=DJOB_QUEUED;
+			if (sek>=0) sprintf(antwort,"OK %i estimate %.1lf\n",j.id,sek);
+			else sprintf(antwort,"OK %i\n",j.id);
+			daemonSendStr(fd,antwort);
+			d->cv.notify_all();
+		} else if ((strcmp(cmd,"STATUS")==0)||(strcmp(cmd,"WAIT")==0)) {
+			std::unique_lock<std::mutex> lock(d->m);
+			DaemonJob* j=(sscanf(&zeile[pos],"%i",&id)==1) ? d->suche(id) : NULL;
+			if (!j) { daemonSendStr(fd,"ERROR unknown job\n"); continue; }
+			if (cmd[0]=='W') {
+				j->warten++;
+				while ((j->zustand==DJOB_QUEUED)||(j->zustand==DJOB_RUNNING)) d->cv.wait(lock);
+				j->warten--;
+			}
+			daemonSendStr(fd,daemonZustand(j,antwort));
+		} else if (strcmp(cmd,"CANCEL")==0) {
+			std::lock_guard<std::mutex> lock(d->m);
+			DaemonJob* j=(sscanf(&zeile[pos],"%i",&id)==1) ? d->suche(id) : NULL;
+			if (!j) { daemonSendStr(fd,"ERROR unknown job\n"); continue; }
+			if (j->zustand==DJOB_QUEUED) j->zustand=DJOB_CANCELLED;
+			else if (j->zustand==DJOB_RUNNING) j->lj->abbruch=1;
+			else { daemonSendStr(fd,"ERROR job finished\n"); continue; }
+			daemonSendStr(fd,"OK\n");
+			d->cv.notify_all();
+		} else if (strcmp(cmd,"FETCH")==0) {
+			// DATA bytes, then the exponents in .ljd layout
+			double* erg=NULL;
+			int32_t ex=0,ey=0;
+			{
+				std::lock_guard<std::mutex> lock(d->m);
+				DaemonJob* j=(sscanf(&zeile[pos],"%i",&id)==1) ? d->suche(id) : NULL;
+				if ((j)&&(j->erg)) {
+					erg=j->erg; ex=j->ergx; ey=j->ergy;
+					j->erg=NULL;
+				}
+			}
+			if (!erg) { daemonSendStr(fd,"ERROR no data\n"); continue; }
+			sprintf(antwort,"DATA %lli\n",(long long)(2*sizeof(int32_t)+(int64_t)ex*ey*sizeof(double)));
+			daemonSendStr(fd,antwort);
+			daemonSend(fd,&ex,sizeof(ex));
+			daemonSend(fd,&ey,sizeof(ey));
+			daemonSend(fd,erg,ex*ey*sizeof(double));
+			delete[] erg;
+		} else if (strcmp(cmd,"SHUTDOWN")==0) {
+			// queued jobs are dropped, running ones finish
+			{
+				std::lock_guard<std::mutex> lock(d->m);
+				d->ende=1;
+				for(int32_t i=0;i<d->anz;i++) if (d->jobs[i].zustand==DJOB_QUEUED) d->jobs[i].zustand=DJOB_CANCELLED;
+			}
+			d->cv.notify_all();
+			daemonSendStr(fd,"OK\n");
+			::shutdown(d->lfd,SHUT_RDWR);
+		} else daemonSendStr(fd,"ERROR unknown command\n");
+	}
+
+	// runDaemon shuts down verbfd at exit, so it is given up before closing
+	{
+		std::lock_guard<std::mutex> lock(d->m);
+		d->verbfd[slot]=-1;
+	}
+	fclose(f);
+}
+#endif
+
+int32_t runDaemon(const char* pfad,const int32_t anzrunner,const int32_t ordnung) {
+	// jobs over a local socket until SHUTDOWN
+	#ifdef __linux__
+	struct sockaddr_un adr;
+	memset(&adr,0,sizeof(adr));
+	adr.sun_family=AF_UNIX;
+	if (strlen(pfad)>=sizeof(adr.sun_path)) { printf("Socket path too long\n"); return 2; }
+	strcpy(adr.sun_path,pfad);
+	int32_t lfd=socket(AF_UNIX,SOCK_STREAM,0);
+	if (lfd<0) { printf("Error creating socket\n"); return 2; }
+	unlink(pfad);
+	if ((bind(lfd,(struct sockaddr*)&adr,sizeof(adr))<0)||(listen(lfd,16)<0)) {
+		printf("Error binding %s\n",pfad);
+		::close(lfd);
+		return 2;
+	}
+
+	Daemon* d=new Daemon;
+	d->jobs=new DaemonJob[MAXDAEMONJOBS];
+	for(int32_t i=0;i<MAXDAEMONCONN;i++) { d->verb[i]=NULL; d->verbfd[i]=-1; }
+	d->anz=0;
+	d->letzteid=0;
+	d->ende=0;
+	d->lfd=lfd;
+	d->ordnung=ordnung;
+
+	int32_t anzt=(anzrunner<1) ? 1 : anzrunner;
+	if (anzt>MAXTHREADS) anzt=MAXTHREADS;
+	std::thread* th[MAXTHREADS];
+	for(int32_t i=0;i<anzt;i++) th[i]=new std::thread(daemonRunner,d);
+	printf("Listening on %s with %i runners\n",pfad,anzt);
+
+	while (1) {
+		int32_t fd=accept(lfd,NULL,NULL);
+		if (fd<0) break;
+		// join the ended connections, a free slot or refuse
+		int32_t frei=-1,beendet[MAXDAEMONCONN],anzbeendet=0;
+		{
+			std::lock_guard<std::mutex> lock(d->m);
+			for(int32_t i=0;i<MAXDAEMONCONN;i++) {
+				if ((d->verb[i])&&(d->verbfd[i]<0)) beendet[anzbeendet++]=i;
+				else if ((!d->verb[i])&&(frei<0)) frei=i;
+			}
+		}
+		for(int32_t k=0;k<anzbeendet;k++) {
+			const int32_t i=beendet[k];
+			d->verb[i]->join();
+			delete d->verb[i];
+			d->verb[i]=NULL;
+			if (frei<0) frei=i;
+		}
+		if (frei<0) {
+			daemonSendStr(fd,"ERROR too many connections\n");
+			::close(fd);
+			continue;
+		}
+		{
+			std::lock_guard<std::mutex> lock(d->m);
+			d->verbfd[frei]=fd;
+		}
+		d->verb[frei]=new std::thread(daemonConnection,d,fd,frei);
+	}
+
+	// running jobs finish first, then open connections are ended, also
+	// the ones in WAIT (their jobs are done or cancelled by now)
+	for(int32_t i=0;i<anzt;i++) { th[i]->join(); delete th[i]; }
+	{
+		std::lock_guard<std::mutex> lock(d->m);
+		for(int32_t i=0;i<MAXDAEMONCONN;i++) if (d->verbfd[i]>=0) ::shutdown(d->verbfd[i],SHUT_RDWR);
+	}
+	d->cv.notify_all();
+	for(int32_t i=0;i<MAXDAEMONCONN;i++) if (d->verb[i]) { d->verb[i]->join(); delete d->verb[i]; }
+	for(int32_t i=0;i<d->anz;i++) if (d->jobs[i].erg) delete[] d->jobs[i].erg;
+	delete[] d->jobs;
+	delete d;
+	::close(lfd);
+	unlink(pfad);
+	printf("Daemon stopped\n");
+	return 0;
+	#else
+	printf("Daemon not supported on this platform\n");
+	return 2;
+	#endif
+}
+
+int32_t runClient(const char* pfad) {
+	// sends stdin line by line and prints the answers.
+	// "FETCH id file" stores the received exponents in file
+	#ifdef __linux__
+	struct sockaddr_un adr;
+	memset(&adr,0,sizeof(adr));
+	adr.sun_family=AF_UNIX;
+	if (strlen(pfad)>=sizeof(adr.sun_path)) { printf("Socket path too long\n"); return 2; }
+	strcpy(adr.sun_path,pfad);
+	int32_t fd=socket(AF_UNIX,SOCK_STREAM,0);
+	if ((fd<0)||(connect(fd,(struct sockaddr*)&adr,sizeof(adr))<0)) {
+		printf("Cannot connect to %s\n",pfad);
+		return 2;
+	}
+	FILE* f=fdopen(fd,"r");
+	char zeile[MAXBATCHLINE],antwort[1200],cmd[64],fn[1024];
+	int32_t fehler=0;
+
+	while (fgets(zeile,MAXBATCHLINE,stdin)) {
+		chomp(zeile);
+		if ((zeile[0]==0)||(zeile[0]=='#')) continue;
+		int32_t id=0;
+		fn[0]=0;
+		cmd[0]=0;
+		sscanf(zeile,"%63s %i %1000s",cmd,&id,fn);
+		upper(cmd);
+		if (strcmp(cmd,"FETCH")==0) sprintf(zeile,"FETCH %i",id);
+		strcat(zeile,"\n");
+		if (daemonSendStr(fd,zeile) <= 0) { fehler=1; break; }
+		if (!fgets(antwort,1200,f)) { fehler=1; break; }
+		long long n=0;
+		if (sscanf(antwort,"DATA %lli",&n)==1) {
+			FILE* fo=(fn[0]) ? fopen(fn,"wb") : NULL;
+			char puffer[65536];
+			for(long long rest=n;rest>0;) {
+				size_t g=fread(puffer,1,(rest<65536) ? rest : 65536,f);
+				if (g<=0) { fehler=1; break; }
+				if (fo) fwrite(puffer,1,g,fo);
+				rest -= g;
+			}
+			if (fo) fclose(fo);
+			printf("%lli bytes%s%s\n",n,(fo) ? " written to " : "",(fo) ? fn : "");
+		} else {
+			printf("%s",antwort);
+			if (strstr(antwort,"ERROR")==antwort) fehler=1;
+		}
+		if (strcmp(cmd,"SHUTDOWN")==0) break;
+	}
+
+	fclose(f);
+	return fehler;
+	#else
+	printf("Client not supported on this platform\n");
+	return 2;
+	#endif
+}
+
+
+// process coordinator
+
+#ifdef __linux__
+int32_t prozLesen(const int32_t fd,void* p,const int64_t n) {
+	// exactly n bytes, 0 on end of stream or error
+	char* q=(char*)p;
+	int64_t rest=n;
+	while (rest>0) {
+		ssize_t g=read(fd,q,rest);
+		if (g<=0) return 0;
+		q += g; rest -= g;
+	}
+	return 1;
+}
+
+int32_t prozZeile(const int32_t fd,char* s,const int32_t maxlen) {
+	// one line without the newline
+	int32_t n=0;
+	while (n<(maxlen-1)) {
+		if (prozLesen(fd,&s[n],1) <= 0) return 0;
+		if (s[n]=='\n') break;
+		n++;
+	}
+	s[n]=0;
+	return 1;
+}
+
+void prozWorker(const int32_t fd) {
+	// protocol, one request at a time:
+	// "PAR n" + n bytes parameter file, "ROWS a b" answered by
+	// "OK a b" + (b-a+1)*lenx exponents or "ERROR text", "QUIT"
+	Ljapunow* lj=new Ljapunow;
+	lj->quiet=1;
+	lj->setthreads(1);
+	int32_t geladen=0;
+	char zeile[256],antwort[256];
+
+	while (prozZeile(fd,zeile,256) > 0) {
+		int32_t a,b;
+		long long n;
+		if (sscanf(zeile,"PAR %lli",&n)==1) {
+			char* par=new char[n];
+			if (prozLesen(fd,par,n) <= 0) { delete[] par; break; }
+			char fn[256];
+			sprintf(fn,"_proc_%i.par",(int32_t)getpid());
+			FILE *f=fopen(fn,"wb");
+			if (f) { fwrite(par,1,n,f); fclose(f); }
+			delete[] par;
+			geladen=(lj->loadpar(fn) > 0);
+			unlink(fn);
+		} else if (sscanf(zeile,"ROWS %i %i",&a,&b)==2) {
+			if ((!geladen)||(a<0)||(b>=lj->leny)||(a>b)) {
+				daemonSendStr(fd,"ERROR rows\n");
+				continue;
+			}
+			lj->calc(a,b);
+			sprintf(antwort,"OK %i %i\n",a,b);
+			if (daemonSendStr(fd,antwort) <= 0) break;
+			if (daemonSend(fd,&lj->exps[a*lj->lenx],(b-a+1)*lj->lenx*sizeof(double)) <= 0) break;
+		} else if (strcmp(zeile,"QUIT")==0) break;
+		else daemonSendStr(fd,"ERROR unknown command\n");
+	}
+	delete lj;
+}
+
+int32_t prozStart(ProzWorker* w,const int32_t nr,const int32_t anzw,const char* par,const int64_t parlen) {
+	// forks worker nr, pinned to its share of the CPUs (consecutive
+	// CPUs, usually those of one NUMA node), and sends the parameters
+	int32_t sv[2];
+	if (socketpair(AF_UNIX,SOCK_STREAM,0,sv)<0) return 0;
+	fflush(stdout);
+	const int32_t pid=fork();
+	if (pid<0) { ::close(sv[0]); ::close(sv[1]); return 0; }
+	if (pid==0) {
+		::close(sv[0]);
+		for(int32_t i=0;i<anzw;i++) if ((i!=nr)&&(w[i].fd>=0)) ::close(w[i].fd);
+		const int32_t cpus=std::thread::hardware_concurrency();
+		if (cpus>0) {
+			cpu_set_t cs;
+			CPU_ZERO(&cs);
+			if (cpus>=anzw) {
+				for(int32_t c=nr*cpus/anzw;c<(nr+1)*cpus/anzw;c++) CPU_SET(c,&cs);
+			} else CPU_SET(nr % cpus,&cs);
+			sched_setaffinity(0,sizeof(cs),&cs);
+		}
+		prozWorker(sv[1]);
+		::close(sv[1]);
+		_exit(0);
+	}
+	::close(sv[1]);
+	w[nr].pid=pid;
+	w[nr].fd=sv[0];
+	w[nr].bereich=-1;
+	char zeile[64];
+	sprintf(zeile,"PAR %lli\n",(long long)parlen);
+	if (
+		(daemonSendStr(sv[0],zeile) <= 0) ||
+		(daemonSend(sv[0],par,parlen) <= 0)
+	) return 0;
+	return 1;
+}
+
+void prozStop(ProzWorker& w) {
+	// workers still busy (slow ones that were overtaken) are killed
+	if (w.fd<0) return;
+	if (w.bereich>=0) kill(w.pid,SIGKILL);
+	else daemonSendStr(w.fd,"QUIT\n");
+	::close(w.fd);
+	waitpid(w.pid,NULL,0);
+	w.fd=-1;
+	w.bereich=-1;
+}
+#endif
+
+int32_t runProc(Ljapunow* ljap,const int32_t anzworker,const int32_t zeilen) {
+	// RUN over local worker processes: the image is split in ranges of
+	// zeilen rows as RUN(a,b) would do by hand, every worker gets the
+	// parameters and then one range at a time. Ranges of crashed
+	// workers are given to others (crashed workers are restarted),
+	// ranges running PROZLANGSAM times longer than the mean are computed
+	// by an idle worker as well, the first answer counts
+	#ifdef __linux__
+	if ((!ljap->fkt)||(!ljap->farbe)||(ljap->seqlen<=0)) { printf("Nothing to compute\n"); return 0; }
+	TraceSpan span("runproc");
+	ljap->skizzeok=0;
+	const int32_t anzw=minimumI((anzworker<1) ? 1 : anzworker,MAXTHREADS);
+	const int32_t zb=(zeilen<1) ? PROZZEILEN : zeilen;
+
+	char fn[64];
+	sprintf(fn,"_proc_%i.par",(int32_t)getpid());
+	ljap->savepar(fn);
+	FILE *f=fopen(fn,"rb");
+	if (!f) return 0;
+	fseek(f,0,SEEK_END);
+	const int64_t parlen=ftell(f);
+	rewind(f);
+	char* par=new char[parlen];
+	fread(par,1,parlen,f);
+	fclose(f);
+	unlink(fn);
+
+	const int32_t anzb=(ljap->leny+zb-1)/zb;
+	ProzBereich* ber=new ProzBereich[anzb];
+	for(int32_t i=0;i<anzb;i++) {
+		ber[i].a=i*zb;
+		ber[i].b=minimumI((i+1)*zb,ljap->leny)-1;
+		ber[i].zustand=PBER_OFFEN;
+		ber[i].tstart=0;
+	}
+	ProzWorker w[MAXTHREADS];
+	for(int32_t i=0;i<anzw;i++) { w[i].fd=-1; w[i].bereich=-1; w[i].neustarts=0; }
+	for(int32_t i=0;i<anzw;i++) if (prozStart(w,i,anzw,par,parlen) <= 0) prozStop(w[i]);
+
+	const int64_t t0=nanosec();
+	int32_t anzfertig=0,anzneu=0,anzdoppelt=0,anzabsturz=0;
+	int64_t summedauer=0;
+	double* puffer=new double[(int64_t)zb*ljap->lenx];
+	char zeile[256];
+
+	while (anzfertig<anzb) {
+		// ranges to idle workers: open ones first, then slow ones
+		int32_t anzlebend=0;
+		for(int32_t i=0;i<anzw;i++) {
+			if (w[i].fd<0) continue;
+			anzlebend++;
+			if (w[i].bereich>=0) continue;
+			int32_t k=-1;
+			for(int32_t j=0;j<anzb;j++) if (ber[j].zustand==PBER_OFFEN) { k=j; break; }
+			if ((k<0)&&(anzfertig>0)) {
+				const int64_t jetzt=nanosec();
+				const double mittel=(double)summedauer/anzfertig;
+				int64_t laengste=0;
+				for(int32_t j=0;j<anzb;j++) {
+					if (ber[j].zustand!=PBER_VERGEBEN) continue;
+					int32_t anzauf=0;
+					for(int32_t v=0;v<anzw;v++) if ((w[v].fd>=0)&&(w[v].bereich==j)) anzauf++;
+					const int64_t d=jetzt-ber[j].tstart;
+					if ((anzauf==1)&&(d>PROZLANGSAM*mittel)&&(d>laengste)) { laengste=d; k=j; }
+				}
+				if (k>=0) anzdoppelt++;
+			}
+			if (k<0) continue;
+			sprintf(zeile,"ROWS %i %i\n",ber[k].a,ber[k].b);
+			if (daemonSendStr(w[i].fd,zeile) <= 0) continue; // noticed by poll
+			w[i].bereich=k;
+			w[i].tstart=nanosec();
+			if (ber[k].zustand==PBER_OFFEN) {
+				ber[k].zustand=PBER_VERGEBEN;
+				ber[k].tstart=w[i].tstart;
+			}
+		}
+		if (anzlebend<=0) break;
+
+		struct pollfd pf[MAXTHREADS];
+		int32_t pw[MAXTHREADS],anzpf=0;
+		for(int32_t i=0;i<anzw;i++) if ((w[i].fd>=0)&&(w[i].bereich>=0)) {
+			pf[anzpf].fd=w[i].fd;
+			pf[anzpf].events=POLLIN;
+			pf[anzpf].revents=0;
+			pw[anzpf++]=i;
+		}
+		if (anzpf<=0) break;
+		if (poll(pf,anzpf,100) <= 0) continue;
+
+		for(int32_t p=0;p<anzpf;p++) {
+			if (pf[p].revents==0) continue;
+			ProzWorker& v=w[pw[p]];
+			const int32_t k=v.bereich;
+			int32_t a=-1,b=-1,ok=0;
 			if (
-				sscanf(&tmp[12],"%lf,%lf,%lf,%lf,%lf,%lf",&a,&b,&c,&d,&e,&f)
-			== 6) ljap->setPosition(a,b,c,d,e,f);
-			else printf("Errror\n");
-		} else if (strstr(utmp,"WALKB(")==utmp) {
-			double a,b;
-			int32_t n;
-			if (sscanf(&tmp[6],"%le,%le,%i",&a,&b,&n) != 3) {
-				printf("Unknown parameters\n");
+				(prozZeile(v.fd,zeile,256) > 0) &&
+				(sscanf(zeile,"OK %i %i",&a,&b)==2) &&
+				(a==ber[k].a) && (b==ber[k].b)
+			) ok=prozLesen(v.fd,puffer,(int64_t)(b-a+1)*ljap->lenx*sizeof(double));
+			v.bereich=-1;
+
+			if (ok>0) {
+				if (ber[k].zustand!=PBER_FERTIG) {
+					memcpy(&ljap->exps[a*ljap->lenx],puffer,(int64_t)(b-a+1)*ljap->lenx*sizeof(double));
+					ber[k].zustand=PBER_FERTIG;
+					summedauer += nanosec()-v.tstart;
+					anzfertig++;
+				}
 				continue;
 			}
-			IterDouble itd(a,b,n);
 
-			if (ljap->fkt->id != ID_FKT_I) {
-				ljap->fkt->set_iterb(&itd); 
+			// crashed or confused: the range goes back unless another
+			// worker has it, the worker is replaced
+			anzabsturz++;
+			printf("worker %i (pid %i) lost at rows %i..%i\n",pw[p],v.pid,ber[k].a,ber[k].b);
+			::close(v.fd);
+			kill(v.pid,SIGKILL);
+			waitpid(v.pid,NULL,0);
+			v.fd=-1;
+			int32_t anzauf=0;
+			for(int32_t i=0;i<anzw;i++) if ((w[i].fd>=0)&&(w[i].bereich==k)) anzauf++;
+			if ((anzauf==0)&&(ber[k].zustand==PBER_VERGEBEN)) ber[k].zustand=PBER_OFFEN;
+			if (v.neustarts<PROZNEUSTARTS) {
+				v.neustarts++;
+				anzneu++;
+				if (prozStart(w,pw[p],anzw,par,parlen) <= 0) prozStop(v);
+			}
+		}
+	}
 
-				Bitmap bmp;
-				ljap->iterStart();
-				do {
-					printf("b=%.10lf ",itd.wert);
-					ljap->fkt->set_b(itd.wert);
-					ljap->calc(0,ljap->leny-1);
+	for(int32_t i=0;i<anzw;i++) prozStop(w[i]);
+	const double sek=(nanosec()-t0)*1E-9;
+	printf("%i of %i ranges of %i rows by %i workers in %.3lf sec\n",anzfertig,anzb,zb,anzw,sek);
+	if ((anzabsturz>0)||(anzdoppelt>0)) printf("%i workers lost, %i restarted, %i ranges duplicated for slow workers\n",anzabsturz,anzneu,anzdoppelt);
+	delete[] puffer;
+	delete[] ber;
+	delete[] par;
+	return (anzfertig==anzb) ? 1 : 0;
+	#else
+	printf("Worker processes not supported on this platform\n");
+	return 0;
+	#endif
+}
+
+
+// tile pyramid
+
+int32_t pyramidStufen(const int32_t lenx,const int32_t leny,const int32_t T) {
+	// level of the full size, level 0 is a single tile
+	int32_t Z=0;
+	while ((lenx>((int64_t)T << Z))||(leny>((int64_t)T << Z))) Z++;
+	return Z;
+}
+
+void pyramidStufe(const int32_t lenx,const int32_t leny,const int32_t Z,const int32_t z,int64_t& b,int64_t& h) {
+	// pixels of level z, halved rounding up per level above Z, doubled below
+	b=lenx;
+	h=leny;
+	if (z>=Z) {
+		b <<= (z-Z);
+		h <<= (z-Z);
+		return;
+	}
+	for(int32_t i=z;i<Z;i++) { b=(b+1)/2; h=(h+1)/2; }
+}
+
+void tileBmp(FILE* f,const uint8_t* q,const int64_t stride,const int64_t x0,const int32_t w,const int32_t h,const int32_t T) {
+	// T x T bitmap of w x h pixels from column x0 of the rows q+i*stride
+	// (top down), the rest black
+	bmpKopf(f,T,T);
+	uint8_t* zeile=new uint8_t[T*3];
+	for(int32_t i=T-1;i>=0;i--) {
+		memset(zeile,0,T*3);
+		if (i<h) memcpy(zeile,&q[i*stride+x0*3],(int64_t)w*3);
+		fwrite(zeile,1,T*3,f);
+	}
+	delete[] zeile;
+}
+
+int32_t pyramidZeile(PyramidEbene* e,const int32_t z,const uint8_t* zeile,const char* dir,const int32_t T) {
+	// next row (top down) of level z. Full tile rows are written, two rows
+	// give one row of level z-1. Returns the number of tiles written
+	PyramidEbene& p=e[z];
+	const int64_t bb=p.breite*3;
+	int32_t anz=0;
+	memcpy(&p.puffer[p.zeilen*bb],zeile,bb);
+	p.zeilen++;
+	p.gesamt++;
+	if ((p.zeilen==T)||(p.gesamt==p.hoehe)) {
+		char fn[1100];
+		for(int64_t tx=0;(tx*T)<p.breite;tx++) {
+			sprintf(fn,"%s/%i/%i_%i.bmp",dir,z,(int32_t)tx,p.tilereihe);
+			FILE *f=fopen(fn,"wb");
+			if (!f) { printf("Error writing %s\n",fn); continue; }
+			tileBmp(f,p.puffer,bb,tx*T,(int32_t)((p.breite-tx*T)<T ? p.breite-tx*T : T),p.zeilen,T);
+			fclose(f);
+			anz++;
+		}
+		p.tilereihe++;
+		p.zeilen=0;
+	}
+	if (z==0) return anz;
+
+	// mean of 2x2 pixels, an odd last row or column counts twice
+	const uint8_t* o;
+	if (!p.halbda) {
+		memcpy(p.halb,zeile,bb);
+		p.halbda=1;
+		if (p.gesamt<p.hoehe) return anz;
+		o=p.halb;
+	} else o=zeile;
+	p.halbda=0;
+	for(int64_t j=0;j<((p.breite+1)/2);j++) {
+		const int64_t x1=2*j*3,x2=((2*j+1)<p.breite) ? (2*j+1)*3 : x1;
+		for(int32_t c=0;c<3;c++) p.halb[j*3+c]=(p.halb[x1+c]+p.halb[x2+c]+o[x1+c]+o[x2+c]+2)/4;
+	}
+	return anz+pyramidZeile(e,z-1,p.halb,dir,T);
+}
+
+int32_t Ljapunow::pyramid(const char* dir,const int32_t T,const int32_t rendern) {
+	// tiles of T x T pixels in dir/z/x_y.bmp (y from the top), level Z
+	// at full size, every level above half the size of the one below.
+	// The image is computed in bands of T rows by a copy of the current
+	// settings and every band is cut into tiles and halved into the
+	// levels above as it arrives, so one band per level is in memory.
+	// dir/pyramid.par/.txt describe it for the tile server, rendern 0:
+	// only those (all tiles on demand). 1: done, 0: cancelled
+	if ((!fkt)||(!farbe)||(seqlen<=0)) { printf("Nothing to compute\n"); return -1; }
+	if ((T<4)||((T % 4)!=0)) { printf("Tile size must be a multiple of 4\n"); return -1; }
+	const int32_t Z=pyramidStufen(lenx,leny,T);
+	char fn[1100],fpar[1100];
+	#ifdef __linux__
+	mkdir(dir,0755);
+	#endif
+	sprintf(fpar,"%s/pyramid.par",dir);
+	savepar(fpar);
+	sprintf(fn,"%s/pyramid.txt",dir);
+	FILE *f=fopen(fn,"wt");
+	if (!f) { printf("Error writing %s\n",fn); return -1; }
+	fprintf(f,"PYRAMID %i %i %i %i\n",lenx,leny,T,Z);
+	fclose(f);
+	printf("pyramid %s: %i x %i pixels, tiles of %i, levels 0..%i\n",dir,lenx,leny,T,Z);
+	if (!rendern) return 1;
+
+	PyramidEbene* e=new PyramidEbene[Z+1];
+	for(int32_t z=0;z<=Z;z++) {
+		pyramidStufe(lenx,leny,Z,z,e[z].breite,e[z].hoehe);
+		e[z].zeilen=e[z].gesamt=e[z].tilereihe=e[z].halbda=0;
+		e[z].puffer=new uint8_t[e[z].breite*3*T];
+		e[z].halb=new uint8_t[e[z].breite*3];
+		sprintf(fn,"%s/%i",dir,z);
+		#ifdef __linux__
+		mkdir(fn,0755);
+		#endif
+	}
+
+	Ljapunow* lj=new Ljapunow;
+	lj->quiet=1;
+	lj->loadpar(fpar);
+	lj->setthreads(threads);
+	lj->setprecision(precision);
+	lj->warmdiv=warmdiv;
+	lj->setsupersample(aasamples,aalambda,aafarbe);
+	Point32_t vx,vy;
+	vx.x=(lowerright.x-lowerleft.x)/lenx; vx.y=(lowerright.y-lowerleft.y)/lenx;
+	vy.x=(upperleft.x-lowerleft.x)/leny; vy.y=(upperleft.y-lowerleft.y)/leny;
+	Bitmap bmp;
+	const int32_t anzb=(leny+T-1)/T;
+	int32_t k,anztiles=0;
+	int64_t t0=nanosec();
+	for(k=0;(k<anzb)&&(!abbruch);k++) {
+		// band k from the top, bitmap rows bottom up
+		TraceSpan frame("band",k);
+		const int32_t hb=minimumI(T,leny-k*T);
+		lj->setlen(lenx,hb);
+		lj->lowerleft.x=upperleft.x-(k*T+hb)*vy.x;
+		lj->lowerleft.y=upperleft.y-(k*T+hb)*vy.y;
+		lj->lowerright.x=lj->lowerleft.x+lenx*vx.x;
+		lj->lowerright.y=lj->lowerleft.y+lenx*vx.y;
+		lj->upperleft.x=lj->lowerleft.x+hb*vy.x;
+		lj->upperleft.y=lj->lowerleft.y+hb*vy.y;
+		lj->calc(0,hb-1);
+		lj->createBmp(&bmp);
+		for(int32_t i=0;i<hb;i++) anztiles += pyramidZeile(e,Z,&bmp.bmp[(int64_t)(hb-1-i)*bmp.ybytes],dir,T);
+		printf("band %i/%i, %i tiles\n",k+1,anzb,anztiles);
+	}
+	printf("%i of %i bands, %i tiles in %.3lf sec\n",k,anzb,anztiles,(nanosec()-t0)*1E-9);
+
+	delete lj;
+	for(int32_t z=0;z<=Z;z++) {
+		delete[] e[z].puffer;
+		delete[] e[z].halb;
+	}
+	delete[] e;
+	return (k==anzb) ? 1 : 0;
+}
+
+#ifdef __linux__
+TileEintrag* tileHolen(TileServer* s,const int32_t z,const int32_t x,const int32_t y) {
+	// cache, else the file of the pyramid, else computed. NULL: no such tile
+	const int32_t T=s->T;
+	if ((z<0)||(z>(s->Z+PYRAMIDTIEFER))||(x<0)||(y<0)) return NULL;
+	s->uhr++;
+	for(int32_t i=0;i<s->anzcache;i++) {
+		TileEintrag& t=s->cache[i];
+		if ((t.z==z)&&(t.x==x)&&(t.y==y)) {
+			t.zeit=s->uhr;
+			s->treffer++;
+			return &t;
+		}
+	}
+	int64_t b,h;
+	pyramidStufe(s->lenx,s->leny,s->Z,z,b,h);
+	if ((((int64_t)x*T)>=b)||(((int64_t)y*T)>=h)) return NULL;
+
+	char* daten=NULL;
+	size_t len=0;
+	char fn[1100];
+	sprintf(fn,"%s/%i/%i_%i.bmp",s->dir,z,x,y);
+	FILE *f=fopen(fn,"rb");
+	if (f) {
+		fseek(f,0,SEEK_END);
+		len=ftell(f);
+		rewind(f);
+		daten=(char*)malloc(len);
+		if (fread(daten,1,len,f)!=len) len=0;
+		fclose(f);
+		s->gelesen++;
+	}
+	if (len==0) {
+		// rows of the tile rounded up to multiples of 4 for calc
+		if (daten) free(daten);
+		const double fak=pow(2.0,s->Z-z);
+		Point32_t vx,vy;
+		vx.x=s->vx.x*fak; vx.y=s->vx.y*fak;
+		vy.x=s->vy.x*fak; vy.y=s->vy.y*fak;
+		const int32_t tw=(int32_t)(((b-(int64_t)x*T)<T) ? b-(int64_t)x*T : T);
+		const int32_t th=(int32_t)(((h-(int64_t)y*T)<T) ? h-(int64_t)y*T : T);
+		const int32_t cw=((tw+3)/4)*4,ch=((th+3)/4)*4;
+		Ljapunow* lj=s->lj;
+		lj->setlen(cw,ch);
+		lj->lowerleft.x=s->ul.x+((double)x*T)*vx.x-((double)y*T+ch)*vy.x;
+		lj->lowerleft.y=s->ul.y+((double)x*T)*vx.y-((double)y*T+ch)*vy.y;
+		lj->lowerright.x=lj->lowerleft.x+cw*vx.x;
+		lj->lowerright.y=lj->lowerleft.y+cw*vx.y;
+		lj->upperleft.x=lj->lowerleft.x+ch*vy.x;
+		lj->upperleft.y=lj->lowerleft.y+ch*vy.y;
+		lj->calc(0,ch-1);
+		Bitmap bmp;
+		lj->createBmp(&bmp);
+		f=open_memstream(&daten,&len);
+		tileBmp(f,&bmp.bmp[(int64_t)(ch-1)*bmp.ybytes],-(int64_t)bmp.ybytes,0,tw,th,T);
+		fclose(f);
+		s->berechnet++;
+	}
+
+	int32_t i=s->anzcache;
+	if (i<s->maxcache) s->anzcache++;
+	else {
+		i=0;
+		for(int32_t k=1;k<s->anzcache;k++) if (s->cache[k].zeit<s->cache[i].zeit) i=k;
+		free(s->cache[i].daten);
+	}
+	TileEintrag& t=s->cache[i];
+	t.z=z; t.x=x; t.y=y;
+	t.daten=(uint8_t*)daten;
+	t.len=(int32_t)len;
+	t.zeit=s->uhr;
+	return &t;
+}
+
+void tileAntwort(const int32_t fd,const char* status,const char* typ,const void* daten,const int32_t len) {
+	char kopf[512];
+	sprintf(kopf,"HTTP/1.0 %s\r\nContent-Type: %s\r\nContent-Length: %i\r\nCache-Control: max-age=3600\r\nConnection: close\r\n\r\n",status,typ,len);
+	if (daemonSendStr(fd,kopf)) daemonSend(fd,daten,len);
+}
+
+// viewer: drag to move, wheel to zoom. Parameters T, Z, width, height, deepest level
+const char* TILEVIEWER=
+	"<!DOCTYPE html><html><head><title>Ljapunow</title></head>\n"
+	"<body style=\"margin:0;overflow:hidden;background:#000\"><div id=\"v\"></div>\n"
+	"<script>\n"
+	"var T=%i,Z=%i,W=%i,H=%i,MAXZ=%i,z=0,ox=0,oy=0,zug=null;\n"
+	"function zeige() {\n"
+	" var b=Math.ceil(W*Math.pow(2,z-Z)),h=Math.ceil(H*Math.pow(2,z-Z)),s='';\n"
+	" for(var y=Math.max(0,Math.floor(-oy/T));(y*T<h)&&(oy+y*T<innerHeight);y++)\n"
+	"  for(var x=Math.max(0,Math.floor(-ox/T));(x*T<b)&&(ox+x*T<innerWidth);x++)\n"
+	"   s+='<img src=\"/'+z+'/'+x+'_'+y+'.bmp\" style=\"position:absolute;left:'+(ox+x*T)+'px;top:'+(oy+y*T)+'px\">';\n"
+	" document.getElementById('v').innerHTML=s;\n"
+	"}\n"
+	"onwheel=function(e) {\n"
+	" var n=z+((e.deltaY<0) ? 1 : -1),f=(n>z) ? 2 : 0.5;\n"
+	" if ((n<0)||(n>MAXZ)) return;\n"
+	" ox=e.clientX-(e.clientX-ox)*f; oy=e.clientY-(e.clientY-oy)*f; z=n; zeige();\n"
+	"};\n"
+	"onmousedown=function(e) { zug=[e.clientX-ox,e.clientY-oy]; e.preventDefault(); };\n"
+	"onmousemove=function(e) { if (zug) { ox=e.clientX-zug[0]; oy=e.clientY-zug[1]; zeige(); } };\n"
+	"onmouseup=function() { zug=null; };\n"
+	"onresize=zeige; zeige();\n"
+	"</script></body></html>\n";
+
+int32_t tileVerbindung(TileServer* s,const int32_t fd) {
+	// one request per connection: GET / viewer, GET /z/x_y.bmp tile,
+	// POST /quit/key (key printed at the start, so pages open in the
+	// browser cannot stop the server). 0: quit
+	char puffer[4096],pfad[1024],methode[8],quit[64];
+	int32_t n=0;
+	puffer[0]=0;
+	// one silent client must not block the others
+	struct timeval tv;
+	tv.tv_sec=TILETIMEOUT;
+	tv.tv_usec=0;
+	setsockopt(fd,SOL_SOCKET,SO_RCVTIMEO,&tv,sizeof(tv));
+	setsockopt(fd,SOL_SOCKET,SO_SNDTIMEO,&tv,sizeof(tv));
+	while (n<4095) {
+		ssize_t r=recv(fd,&puffer[n],4095-n,0);
+		if (r<=0) break;
+		n += r;
+		puffer[n]=0;
+		if (strstr(puffer,"\r\n\r\n")) break;
+	}
+	int32_t z,x,y,weiter=1;
+	sprintf(quit,"/quit/%s",s->schluessel);
+	if (sscanf(puffer,"%7s %1000s",methode,pfad)!=2) {
+		tileAntwort(fd,"400 Bad Request","text/plain","bad request\n",12);
+	} else if (strcmp(methode,"POST")==0) {
+		if (strcmp(pfad,quit)==0) {
+			tileAntwort(fd,"200 OK","text/plain","stopped\n",8);
+			weiter=0;
+		} else tileAntwort(fd,"403 Forbidden","text/plain","forbidden\n",10);
+	} else if (strcmp(methode,"GET")!=0) {
+		tileAntwort(fd,"405 Method Not Allowed","text/plain","bad method\n",11);
+	} else if (strcmp(pfad,"/")==0) {
+		char html[4096];
+		sprintf(html,TILEVIEWER,s->T,s->Z,s->lenx,s->leny,s->Z+PYRAMIDTIEFER);
+		tileAntwort(fd,"200 OK","text/html",html,strlen(html));
+	} else if (sscanf(pfad,"/%i/%i_%i.bmp",&z,&x,&y)==3) {
+		TileEintrag* t=tileHolen(s,z,x,y);
+		if (t) tileAntwort(fd,"200 OK","image/bmp",t->daten,t->len);
+		else tileAntwort(fd,"404 Not Found","text/plain","no such tile\n",13);
+	} else tileAntwort(fd,"404 Not Found","text/plain","not found\n",10);
+	::close(fd);
+	return weiter;
+}
+#endif
+
+int32_t runTileServer(const char* dir,const int32_t port,const int32_t mb) {
+	// the pyramid in dir over HTTP on 127.0.0.1:port until POST /quit/key,
+	// tiles not on disk are computed and cached in mb MB
+	#ifdef __linux__
+	TileServer* s=new TileServer;
+	char fn[1100];
+	snprintf(s->dir,sizeof(s->dir),"%s",dir);
+	sprintf(fn,"%s/pyramid.txt",dir);
+	FILE *f=fopen(fn,"rt");
+	if ((!f)||(fscanf(f,"PYRAMID %i %i %i %i",&s->lenx,&s->leny,&s->T,&s->Z)!=4)) {
+		printf("No pyramid in %s (PYRAMID command)\n",dir);
+		if (f) fclose(f);
+		return 2;
+	}
+	fclose(f);
+	if ((s->lenx<1)||(s->leny<1)||(s->T<4)||((s->T % 4)!=0)||(s->Z!=pyramidStufen(s->lenx,s->leny,s->T))) {
+		printf("Invalid %s\n",fn);
+		return 2;
+	}
+	uint64_t zufall=(uint64_t)nanosec() ^ ((uint64_t)getpid() << 32);
+	f=fopen("/dev/urandom","rb");
+	if (f) {
+		if (fread(&zufall,sizeof(zufall),1,f)!=1) zufall ^= (uint64_t)nanosec();
+		fclose(f);
+	}
+	sprintf(s->schluessel,"%016llx",(unsigned long long)zufall);
+	s->lj=new Ljapunow;
+	s->lj->quiet=1;
+	sprintf(fn,"%s/pyramid.par",dir);
+	if (s->lj->loadpar(fn) <= 0) { printf("Error loading %s\n",fn); return 2; }
+	Ljapunow* lj=s->lj;
+	s->ul=lj->upperleft;
+	s->vx.x=(lj->lowerright.x-lj->lowerleft.x)/s->lenx; s->vx.y=(lj->lowerright.y-lj->lowerleft.y)/s->lenx;
+	s->vy.x=(lj->upperleft.x-lj->lowerleft.x)/s->leny; s->vy.y=(lj->upperleft.y-lj->lowerleft.y)/s->leny;
+	s->maxcache=(int32_t)(((int64_t)mb << 20)/((int64_t)s->T*s->T*3+BMPKOPF));
+	if (s->maxcache<1) s->maxcache=1;
+	s->cache=new TileEintrag[s->maxcache];
+	s->anzcache=0;
+	s->uhr=s->treffer=s->gelesen=s->berechnet=0;
+
+	struct sockaddr_in adr;
+	memset(&adr,0,sizeof(adr));
+	adr.sin_family=AF_INET;
+	adr.sin_port=htons(port);
+	adr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+	int32_t lfd=socket(AF_INET,SOCK_STREAM,0);
+	if (lfd<0) { printf("Error creating socket\n"); return 2; }
+	int32_t ja=1;
+	setsockopt(lfd,SOL_SOCKET,SO_REUSEADDR,&ja,sizeof(ja));
+	if ((bind(lfd,(struct sockaddr*)&adr,sizeof(adr))<0)||(listen(lfd,16)<0)) {
+		printf("Error binding port %i\n",port);
+		::close(lfd);
+		return 2;
+	}
+	printf("Serving %s (%i x %i, levels 0..%i, on demand to %i) on http://127.0.0.1:%i/, cache %i tiles\n",
+		dir,s->lenx,s->leny,s->Z,s->Z+PYRAMIDTIEFER,port,s->maxcache);
+	printf("Stop with: curl -X POST http://127.0.0.1:%i/quit/%s\n",port,s->schluessel);
+	fflush(stdout);
+
+	// one request at a time, calc uses all threads
+	while (1) {
+		int32_t fd=accept(lfd,NULL,NULL);
+		if (fd<0) break;
+		if (tileVerbindung(s,fd) <= 0) break;
+	}
+	::close(lfd);
+	printf("tiles: %lli from cache, %lli from disk, %lli computed\n",(long long)s->treffer,(long long)s->gelesen,(long long)s->berechnet);
+	for(int32_t i=0;i<s->anzcache;i++) free(s->cache[i].daten);
+	delete[] s->cache;
+	delete s->lj;
+	delete s;
+	return 0;
+	#else
+	printf("Tile server not supported on this platform\n");
+	return 2;
+	#endif
+}
+
+
+// menu jobs
+
+int32_t menuJobBefehl(const char* utmp) {
+	// RUN and the walks, RUNPROC is a command of its own
+	const char* JOBS[]={ "RUN","WALKSEQ(","WALKB(","WALKSECTION","WALKRGB","WALKDET(","WALKTILE(","PYRAMID(","VOLUME(" };
+	if (strstr(utmp,"RUNPROC(")==utmp) return 0;
+	for(int32_t i=0;i<(int32_t)(sizeof(JOBS)/sizeof(JOBS[0]));i++) if (strstr(utmp,JOBS[i])==utmp) return 1;
+	return 0;
+}
+
+int32_t menuJob(Ljapunow* ljap,char* tmp,const char* utmp) {
+	// RUN or a walk. The walks stop after the current frame once
+	// ljap->abbruch is set, calc after the current rows.
+	// -1: not a job command, 0: error or cancelled
+	if (strstr(utmp,"WALKSEQ(")==utmp) {
+		int32_t anz,slen;
+		
+		if (sscanf(&utmp[8],"%i,%i",&anz,&slen) != 2) { 
+			printf("Error\n");
+			return 0; 
+		}
+
+		char ts[500];
+		if (slen>64) slen=64;
+		ts[slen]=0;
+		
+		ljap->gatestart();
+		for(int n=0;(n<anz)&&(!ljap->abbruch);n++) {
+			TraceSpan frame("frame",n+1);
+			for(int32_t i=0;i<slen;i++) ts[i]='A'+rand()%2;
+			ljap->setSequence(ts);
+			printf("%s ",ts);
+			if (ljap->walkcalc() <= 0) continue;
+
+			char fn[1024],orig[1024];
+			sprintf(orig,"_walkseq_%04i_%s",n+1,ts); 
+			sprintf(fn,"%s.bmp",orig);
+			ljap->savebmp(fn,NULL);
+			sprintf(fn,"%s.par",orig);
+			ljap->savepar(fn);
+			sprintf(fn,"%s.ljd",orig);
+			ljap->saveexp(fn);
+		} // n
+		ljap->gatereport();
+	} else if (strstr(utmp,"WALKB(")==utmp) {
+		double a,b;
+		int32_t n;
+		if (sscanf(&tmp[6],"%le,%le,%i",&a,&b,&n) != 3) {
+			printf("Unknown parameters\n");
+			return 0;
+		}
+		IterDouble itd(a,b,n);
+
+		if (ljap->fkt->id != ID_FKT_I) {
+			ljap->fkt->set_iterb(&itd); 
+
+			Bitmap bmp;
+			ljap->gatestart();
+			ljap->iterStart();
+			do {
+				TraceSpan frame("frame",iterfilecount);
+				printf("b=%.10lf ",itd.wert);
+				ljap->fkt->set_b(itd.wert);
+				if (ljap->walkcalc() > 0) {
 					char fn[1000];
 					sprintf(tmp,"_walkb%04i_b_%+.10lf",iterfilecount,itd.wert);
 					sprintf(fn,"%s.bmp",tmp); 
@@ -2039,115 +7321,124 @@ int32_t main(int32_t argc,char** argv) {
 					ljap->savepar(fn);
 					sprintf(fn,"%s.ljd",tmp); 
 					ljap->saveexp(fn);
-					iterfilecount++; 
-				} while (ljap->iterWeiter());
-			}
-		} else if (!strcmp(utmp,"WALKSECTION")) {
-			if (ljap->fkt->typ != FKTTYP_ABSCHNITTSWEISE) continue;
-
-			FunctionMetaABSC *fvi=(FunctionMetaABSC*)ljap->fkt;
-
-			int32_t ctr=1;
-
-			char tmp[1024];
-			const double i0START=-1.0;
-			const double bis=1.0;
-			const double delta=0.5;
-
-			for(double i0min=i0START;i0min < bis;i0min += delta) {
-				printf("i0=%f to %f\n",i0min,bis);
-				for(double i0max=(i0min+delta);i0max < bis;i0max += delta) {
-					for(double i1min=i0START;i1min < bis;i1min += delta) {
-						printf("i1=%f to %f\n",i1min,bis);
-						for(double i1max=(i1min+delta);i1max < bis;i1max += delta) {
-							fvi->setsections(i0min,i0max,i1min,i1max);
-							ljap->calc(0,ljap->leny-1);
+				}
+				iterfilecount++; 
+			} while ((!ljap->abbruch)&&(ljap->iterWeiter()));
+			ljap->gatereport();
+		}
+	} else if (!strcmp(utmp,"WALKSECTION")) {
+		if (ljap->fkt->typ != FKTTYP_ABSCHNITTSWEISE) return 0;
+
+		FunctionMetaABSC *fvi=(FunctionMetaABSC*)ljap->fkt;
+
+		int32_t ctr=1;
+
+		char tmp[1024];
+		const double i0START=-1.0;
+		const double bis=1.0;
+		const double delta=0.5;
+
+		ljap->gatestart();
+		for(double i0min=i0START;(i0min < bis)&&(!ljap->abbruch);i0min += delta) {
+			printf("i0=%f to %f\n",i0min,bis);
+			for(double i0max=(i0min+delta);(i0max < bis)&&(!ljap->abbruch);i0max += delta) {
+				for(double i1min=i0START;(i1min < bis)&&(!ljap->abbruch);i1min += delta) {
+					printf("i1=%f to %f\n",i1min,bis);
+					for(double i1max=(i1min+delta);(i1max < bis)&&(!ljap->abbruch);i1max += delta) {
+						TraceSpan frame("frame",ctr);
+						fvi->setsections(i0min,i0max,i1min,i1max);
+						if (ljap->walkcalc() > 0) {
 							sprintf(tmp,"_walksection%04i.bmp",ctr); 
 							ljap->savebmp(tmp,NULL);
 							sprintf(tmp,"_walksection%04i.par",ctr); 
 							ljap->savepar(tmp);
-							ctr++;
 						}
+						ctr++;
 					}
-				} 
+				}
 			} 
-		} else if (strcmp(utmp,"WALKRGB")==NULL) {
-			Bitmap bmp;
-			srand(time(NULL));
-			int r1,g1,b1,r2,g2,b2,idx;
-			for(int i=0;i<MAXRGBITERS;i++) {
-				idx=rand()%ljap->farbe->intanz;
-				#define RNDF rand()%256;
-				r1=RNDF; g1=RNDF; b1=RNDF;
-				r2=RNDF; g2=RNDF; b2=RNDF;
-				
-				ljap->farbe->ints[idx]->setfarbel(r1,g1,b1);
-				ljap->farbe->ints[idx]->setfarber(r2,g2,b2);
-				char fn[1024];
-				sprintf(fn,"_walkrgb_%04i.bmp",i+1);
-				ljap->savebmp(fn,&bmp);
-				printf(".");
-				sprintf(fn,"_walkrgb_%04i.par",i+1); 
-				ljap->savepar(fn);
-
-				char ff[1024]; 
-				int32_t c=1; 
-				if (getFirstColorFile(ff) <= 0) continue; 
-				do { 
-					if (ljap->loadcolor(ff) > 0) { 
-						sprintf(fn,"_walkcolordir_%04i.par",c);  
-						ljap->savepar(fn); 
-						printf("."); 
-						sprintf(fn,"_walkcolordir_%04i.bmp",c); 
-						ljap->savebmp(fn,NULL);
-						c++; 
-					} 
-				} while (getNextColorFile(ff) > 0); 
-			} // i
-		} else if (strstr(utmp,"WALKDET(")==utmp) {
-			double b0,b1;
-			int32_t fktid,abl0,abl1,n;
-			if (sscanf(&tmp[8],"%i,%i,%i,%lf,%lf,%i",
-				&fktid,&abl0,&abl1,&b0,&b1,&n) != 6) 
-			{
-				printf("Error parameters\n");
-				continue;
-			}
-
+		} 
+		ljap->gatereport();
+	} else if (strcmp(utmp,"WALKRGB")==NULL) {
+		Bitmap bmp;
+		srand(time(NULL));
+		int r1,g1,b1,r2,g2,b2,idx;
+		for(int i=0;(i<MAXRGBITERS)&&(!ljap->abbruch);i++) {
+			TraceSpan frame("frame",i+1);
+			idx=rand()%ljap->farbe->intanz;
+			#define RNDF rand()%256;
+			r1=RNDF; g1=RNDF; b1=RNDF;
+			r2=RNDF; g2=RNDF; b2=RNDF;
+			
+			ljap->farbe->ints[idx]->setfarbel(r1,g1,b1);
+			ljap->farbe->ints[idx]->setfarber(r2,g2,b2);
 			char fn[1024];
-			Function* fktp=getNewFunction(fktid);
-			if (!fktp) {
-				printf("Error. Function not recognized.\n");
-				continue;
-			}
-			FunctionMetaDet* hierp=(FunctionMetaDet*)getNewFunction(ID_FKT_METADET);
-			Function *sicp=ljap->fkt;
-			ljap->fkt=hierp;
-			hierp->f=fktp;
-
-			for(int32_t abl=abl0;abl<=abl1;abl++) {
-				if (
-					(abl == ID_FKT_METADET) ||
-					(abl == ID_FKT_METAABSC)
-				) continue;
-				
-				Function* ablp=getNewFunction(abl);
-				if (!ablp) continue; // not existent
-				printf("derivative %i\n",abl);
-				hierp->abl=ablp;
-
-				IterDouble itd(b0,b1,n);
-				ljap->fkt->set_iterb(&itd); // auch bei eigentlich nicht unterstützenden Functionen
-
-				for(int32_t fwas=1;fwas<=2;fwas++) for(int32_t ablwas=1;ablwas<=2;ablwas++) {
-					ljap->iterStart();
-					hierp->fwas=fwas;
-					hierp->ablwas=ablwas;
-
-					do {
-						ljap->fkt->set_b(itd.wert);
-						printf("%lf",itd.wert);
-						ljap->calc(0,ljap->leny-1);
+			sprintf(fn,"_walkrgb_%04i.bmp",i+1);
+			ljap->savebmp(fn,&bmp);
+			printf(".");
+			sprintf(fn,"_walkrgb_%04i.par",i+1); 
+			ljap->savepar(fn);
+
+			char ff[1024]; 
+			int32_t c=1; 
+			if (getFirstColorFile(ff) <= 0) continue; 
+			do { 
+				if (ljap->loadcolor(ff) > 0) { 
+					sprintf(fn,"_walkcolordir_%04i.par",c);  
+					ljap->savepar(fn); 
+					printf("."); 
+					sprintf(fn,"_walkcolordir_%04i.bmp",c); 
+					ljap->savebmp(fn,NULL);
+					c++; 
+				} 
+			} while (getNextColorFile(ff) > 0); 
+		} // i
+	} else if (strstr(utmp,"WALKDET(")==utmp) {
+		double b0,b1;
+		int32_t fktid,abl0,abl1,n;
+		if (sscanf(&tmp[8],"%i,%i,%i,%lf,%lf,%i",
+			&fktid,&abl0,&abl1,&b0,&b1,&n) != 6) 
+		{
+			printf("Error parameters\n");
+			return 0;
+		}
+
+		char fn[1024];
+		Function* fktp=getNewFunction(fktid);
+		if (!fktp) {
+			printf("Error. Function not recognized.\n");
+			return 0;
+		}
+		FunctionMetaDet* hierp=(FunctionMetaDet*)getNewFunction(ID_FKT_METADET);
+		Function *sicp=ljap->fkt;
+		ljap->fkt=hierp;
+		hierp->f=fktp;
+		ljap->gatestart();
+
+		for(int32_t abl=abl0;(abl<=abl1)&&(!ljap->abbruch);abl++) {
+			if (
+				(abl == ID_FKT_METADET) ||
+				(abl == ID_FKT_METAABSC)
+			) continue;
+			
+			Function* ablp=getNewFunction(abl);
+			if (!ablp) continue; // not existent
+			printf("derivative %i\n",abl);
+			hierp->abl=ablp;
+
+			IterDouble itd(b0,b1,n);
+			ljap->fkt->set_iterb(&itd); // auch bei eigentlich nicht unterstützenden Functionen
+
+			for(int32_t fwas=1;(fwas<=2)&&(!ljap->abbruch);fwas++) for(int32_t ablwas=1;(ablwas<=2)&&(!ljap->abbruch);ablwas++) {
+				ljap->iterStart();
+				hierp->fwas=fwas;
+				hierp->ablwas=ablwas;
+
+				do {
+					TraceSpan frame("frame",itd.nr+1);
+					ljap->fkt->set_b(itd.wert);
+					printf("%lf",itd.wert);
+					if (ljap->walkcalc() > 0) {
 						char fn[1000];
 						sprintf(tmp,"_walkdet%02i_%02i_%04i_b_%+.10lf",fktid,abl,iterfilecount,itd.wert);
 						sprintf(fn,"%s.bmp",tmp); 
@@ -2156,30 +7447,263 @@ int32_t main(int32_t argc,char** argv) {
 						ljap->savepar(fn);
 						sprintf(fn,"%s.ljd",tmp); 
 						ljap->saveexp(fn);
+					}
+				} while ((!ljap->abbruch)&&(ljap->iterWeiter()));
+				iterfilecount++;
+			} 
 
-					} while (ljap->iterWeiter());
-					iterfilecount++;
-				} 
+			delete ablp;
+		}
 
-				delete ablp;
+		ljap->gatereport();
+		delete fktp;
+		delete hierp;
+		ljap->fkt=sicp;
+	} else if (strstr(utmp,"WALKTILE(")==utmp) {
+		int32_t anzx,anzy;
+
+		int32_t einzeln=1;
+		if (sscanf(&utmp[9],"%i,%i,%i",&anzx,&anzy,&einzeln) < 2) { printf("Error\n");return 0; }
+		sprintf(tmp,"%04i",tilefilenr++);
+
+		ljap->tile(tmp,anzx,anzy,einzeln);
+	} else if (strstr(utmp,"RUN")==utmp) {
+		int32_t start,ende;
+		if (strcmp(utmp,"RUN")==0) {
+			start=0;
+			ende=ljap->leny-1;
+		} else {
+			if (sscanf(&tmp[4],"%i,%i",&start,&ende) != 2) {
+				start=0;
+				ende=ljap->leny-1;
 			}
+		}
+		TraceSpan frame("run");
+		time_t a,b;
+		a=time(NULL);
+		const int32_t ok=ljap->calc(start,ende);
+		b=time(NULL);
+		double d=difftime(b,a);
+		printf("Time used %.2lf sec\n",d);
+		// LOADCOLOR of the menu waits for the images
+		std::lock_guard<std::mutex> lock(menujob.m);
+		if (ok<=0) {
+			ljap->savepartial("tmpljap");
+			printf("%s cancelled\n",utmp);
+			return 0;
+		}
+		sprintf(tmp,"tmpljap.bmp"); ljap->savebmp(tmp,NULL);
+		sprintf(tmp,"tmpljap.par"); ljap->savepar(tmp);
+		sprintf(tmp,"tmpljap.ljd"); ljap->saveexp(tmp);
+	} else if (strstr(utmp,"PYRAMID(")==utmp) {
+		char dir[1024];
+		int32_t T=PYRAMIDTILE,rendern=1;
+		if (sscanf(&tmp[8],"%1000[^,],%i,%i",dir,&T,&rendern) < 1) { printf("Error\n");return 0; }
+		if (ljap->pyramid(dir,T,rendern) < 0) return 0;
+	} else if (strstr(utmp,"VOLUME(")==utmp) {
+		char name[1024];
+		int32_t anz,vorschau=1;
+		double c0,c1;
+		if (sscanf(&tmp[7],"%1000[^,],%i,%lf,%lf,%i",name,&anz,&c0,&c1,&vorschau) < 4) { printf("Error\n");return 0; }
+		if (ljap->volume(name,anz,c0,c1,vorschau) < 0) return 0;
+	} else return -1;
+
+	if (ljap->abbruch) {
+		printf("%s cancelled\n",utmp);
+		return 0;
+	}
+	return 1;
+}
+
+void menuJobThread(void) {
+	menuJob(ljap,menujob.tmp,menujob.utmp);
+	menujob.t0=nanosec()-menujob.t0;
+	menujob.laeuft=0;
+}
+
+void menuJobStart(const char* tmp,const char* utmp) {
+	// in the menu thread, in ASYNC mode in the background
+	ljap->abbruch=0;
+	strcpy(menujob.tmp,tmp);
+	strcpy(menujob.utmp,utmp);
+	if (!async) {
+		menuJob(ljap,menujob.tmp,menujob.utmp);
+		return;
+	}
+	// STATUS and SAVE before calc sets up its rows see none done
+	ljap->zeilenstart(0,ljap->leny-1,ljap->leny);
+	menujob.t0=nanosec();
+	menujob.laeuft=1;
+	menujob.th=new std::thread(menuJobThread);
+	printf("job %s started\n",utmp);
+}
+
+int32_t menuJobEnde(const int32_t warten) {
+	// joins the finished job, with warten also the running one.
+	// 0: no job to join
+	if (!menujob.th) return 0;
+	if ((menujob.laeuft)&&(!warten)) return 0;
+	menujob.th->join();
+	delete menujob.th;
+	menujob.th=NULL;
+	printf("job %s finished after %.3lf sec\n",menujob.utmp,menujob.t0*1E-9);
+	return 1;
+}
+
+
+// main routine
+
+int32_t main(int32_t argc,char** argv) {
+	srand(time(NULL));
+	// client=socket: send stdin to a render daemon
+	for(int32_t i=1;i<argc;i++) if (strstr(argv[i],"client=")==argv[i]) return runClient(&argv[i][7]);
+	isadetected=isa=detectIsa();
+	// isa=sse2/avx2/avx512 on the command line overrides the detection
+	for(int32_t i=1;i<argc;i++) if (strstr(argv[i],"isa=")==argv[i]) {
+		for(int32_t k=0;k<ANZISA;k++) if (strcmp(&argv[i][4],ISANAMES[k])==0) setIsa(k);
+	}
+	printf("instruction set %s (cpu supports %s)\n",ISANAMES[isa],ISANAMES[isadetected]);
+
+	// batch=manifest [jobs=n] [mem=MB]: run the manifest and exit
+	// cache=MB: result cache in CACHEDIR (all modes)
+	// order=estimate: batch longest, daemon shortest estimated job first
+	const char* batch=NULL;
+	int32_t batchjobs=std::thread::hardware_concurrency(),batchmem=BATCHMEMMB;
+	int32_t ordnung=0;
+	int32_t port=TILEPORT,tilemb=TILECACHEMB;
+	setCache(0,NULL);
+	for(int32_t i=1;i<argc;i++) {
+		if (strstr(argv[i],"batch=")==argv[i]) batch=&argv[i][6];
+		else if (strstr(argv[i],"cache=")==argv[i]) setCache(atoi(&argv[i][6]),NULL);
+		else if (strstr(argv[i],"jobs=")==argv[i]) batchjobs=atoi(&argv[i][5]);
+		else if (strstr(argv[i],"mem=")==argv[i]) batchmem=atoi(&argv[i][4]);
+		else if (strcmp(argv[i],"order=estimate")==0) ordnung=1;
+		else if (strstr(argv[i],"port=")==argv[i]) port=atoi(&argv[i][5]);
+		else if (strstr(argv[i],"tilecache=")==argv[i]) tilemb=atoi(&argv[i][10]);
+	}
+	if (batch) return runBatch(batch,batchjobs,batchmem,"_batch.json",ordnung);
+	// serve=socket [jobs=n]: render daemon
+	for(int32_t i=1;i<argc;i++) if (strstr(argv[i],"serve=")==argv[i]) return runDaemon(&argv[i][6],batchjobs,ordnung);
+	// tiles=dir [port=n] [tilecache=MB]: HTTP tile server of a PYRAMID
+	for(int32_t i=1;i<argc;i++) if (strstr(argv[i],"tiles=")==argv[i]) return runTileServer(&argv[i][6],port,tilemb);
+	ljap=new Ljapunow;
+	ffarbe=NULL;
+	menujob.th=NULL;
+	menujob.laeuft=0;
+
+	char tmp[1000],utmp[1000];
+	int32_t defect=0;
+
+	while (1) {
+		printf("\n\n\nLjapunow\n");
+		if (defect>0) {
+			printf("\n\nError in function. Load anew recommended\n\n");
+		} else if (menujob.laeuft) {
+			// the walks change the settings while they run
+			printf("job %s running\n",menujob.utmp);
+		} else {
+			if (ljap->fn[0]>0) printf("File %s\n",ljap->fn);
+			if (ljap->fkt) printf("function %s\n",ljap->fkt->fktStr(tmp)); else printf("Function undefiniert\n");
+			printf("upper left(%le|%le)\nlower left(%le|%le)\nlower right(%le|%le)\n",ljap->upperleft.x,ljap->upperleft.y,ljap->lowerleft.x,ljap->lowerleft.y,ljap->lowerright.x,ljap->lowerright.y);
+			printf("Image size (%i|%i)\n",ljap->lenx,ljap->leny);
+			printf("sequence %s\n",ljap->getSequence(tmp));
+			if (ljap->mitC()) printf("C %.17lg\n",ljap->cwert);
+			printf("iterations (%i|%i)\n",ljap->iter0,ljap->iter1);
+			printf("threads %i\n",ljap->threads);
+			printf("precision %s\n",PRECISIONNAMES[ljap->precision]);
+			printf("instruction set %s\n",ISANAMES[isa]);
+			printf("================================\n\n");
+		}
+
+		printf("\n> ");
+		gets(tmp);
+		defect=0; 
+
+		chomp(tmp);	sprintf(utmp,"%s",tmp);
+		for(int32_t i=(strlen(tmp)-1);i>=0;i--) if (tmp[i]==')') { tmp[i]=0; break; }
+		upper(utmp);
+
+		// while a job runs: its control, and recoloring and saving the
+		// rows computed so far of a RUN
+		menuJobEnde(0);
+		const int32_t farbbar=
+			(strstr(menujob.utmp,"RUN")==menujob.utmp) && (
+				(strstr(utmp,"LOADCOLOR(")==utmp) ||
+				(strstr(utmp,"SAVE(")==utmp) ||
+				(strstr(utmp,"WR(")==utmp)
+			);
+		if (
+			(menujob.laeuft) && (!farbbar) &&
+			(strcmp(utmp,"STATUS")!=0) && (strcmp(utmp,"CANCEL")!=0) &&
+			(strcmp(utmp,"WAIT")!=0) && (strcmp(utmp,"E")!=0)
+		) {
+			printf("Busy: %s running. STATUS, CANCEL, WAIT\n",menujob.utmp);
+			continue;
+		}
+
+		if (strcmp(utmp,"E")==0) {
+			ljap->abbruch=1;
+			menuJobEnde(1);
+			break;
+		}
+		else if (strstr(utmp,"LOAD(")==utmp) {
+			char d[1024],fn[500],b[500];
+			sprintf(d,"%s",&tmp[5]);
+			stripext(d);
+			sprintf(fn,"%s.par",d);
+			if (ljap->loadpar(fn) > 0) {
+				printf("Parameters loaded\n"); 
+				sprintf(fn,"%s.ljd",d);
+				// if not existent, no problem
+				if (ljap->loadexp(fn) > 0) printf("Lyapunov values loaded\n");
+				strcpy(ljap->fn,d);
+			} else { 
+				defect=1; 
+				printf("Error loading %s\n",fn);
+				ljap->fn[0]=0;
+			}
+		} else if (strstr(utmp,"LOADCOLOR(")==utmp) {
+			char fn[1024];
+			if (strstr(utmp,".PAR")==NULL) {
+				sprintf(fn,"%s.par",&utmp[10]);
+			} else strcpy(fn,&utmp[10]);
 
-			delete fktp;
-			delete hierp;
-			ljap->fkt=sicp;
+			std::lock_guard<std::mutex> lock(menujob.m);
+			if (ljap->loadcolor(fn) <= 0) defect=1;
+		} else if (strstr(utmp,"SETSIZE(")==utmp) {
+			int32_t xl,yl;
+			if (sscanf(&utmp[8],"%i,%i",&xl,&yl) != 2) { printf("Error\n");continue; }
+			ljap->setlen(xl,yl);
+		} else if (strstr(utmp,"SETITER(")==utmp) {
+			int32_t a,b;
+			if (sscanf(&utmp[8],"%i,%i",&a,&b) != 2) { printf("Error\n");continue; }
+			ljap->setiter(a,b);
+		} else if (strstr(utmp,"ROTATEDEG(")==utmp) {
+			int32_t w;
+			if (sscanf(&utmp[10],"%i",&w) != 1) { printf("Error\n"); continue; }
+			ljap->rot(w);
+		} else if (strstr(utmp,"STRETCH(")==utmp) {
+			double fx;
+			if (sscanf(&tmp[8],"%le",&fx) != 1) { printf("Error\n");continue; }
+			ljap->stretch(fx,fx);
+		} else if (strstr(utmp,"SETSEQUENCE(")==utmp) {
+			ljap->setSequence(&tmp[12]);
+		} else if (strstr(utmp,"SETC(")==utmp) {
+			double c;
+			if (sscanf(&tmp[5],"%lf",&c) != 1) { printf("Error\n");continue; }
+			ljap->cwert=c;
+		} else if (strstr(utmp,"SETPOSITION(")==utmp) {
+			double a,b,c,d,e,f;
+			if (
+				sscanf(&tmp[12],"%lf,%lf,%lf,%lf,%lf,%lf",&a,&b,&c,&d,&e,&f)
+			== 6) ljap->setPosition(a,b,c,d,e,f);
+			else printf("Errror\n");
 		} else if ( (strstr(utmp,"CROP(")==utmp) || (strstr(utmp,"C(")==utmp) ) {
 			int32_t pulneux,pulneuy,porneux,porneuy;
 
 			if (sscanf(&utmp[5],"%i,%i,%i,%i",&pulneux,&pulneuy,&porneux,&porneuy) != 4) { printf("Error\n");continue; }
 
 			ljap->crop(pulneux,pulneuy,porneux,porneuy);
-		} else if (strstr(utmp,"WALKTILE(")==utmp) {
-			int32_t anzx,anzy;
-
-			if (sscanf(&utmp[9],"%i,%i",&anzx,&anzy) != 2) { printf("Error\n");continue; }
-			sprintf(tmp,"%04i",tilefilenr++);
-
-			ljap->tile(tmp,anzx,anzy);
 		} else if (strstr(utmp,"CENTER(")==utmp) {
 			int32_t x,y;
 			if (sscanf(&utmp[7],"%i,%i",&x,&y) != 2) { printf("Error\n");continue; }
@@ -2189,31 +7713,134 @@ int32_t main(int32_t argc,char** argv) {
 			char fn2[1024]; strcpy(fn2,&tmp[5]);
 			int32_t lp=strlen(fn2)-1;
 			while (lp>=0) if (fn2[lp] == '.') { fn2[lp]=0; break; } else lp--;
+			std::lock_guard<std::mutex> lock(menujob.m);
+			if (menujob.laeuft) {
+				ljap->savepartial(fn2);
+				continue;
+			}
 			sprintf(fn,"%s.bmp",fn2); ljap->savebmp(fn,0);
 			sprintf(fn,"%s.par",fn2); ljap->savepar(fn);
 			sprintf(fn,"%s.ljd",fn2); ljap->saveexp(fn);
 			sprintf(fn,"%s.descr",&tmp[5]);
 			if (ljap->lenx >= 600) ljap->savedescr(fn);
-		} else if (strstr(utmp,"RUN")==utmp) {
-			int32_t start,ende;
-			if (strcmp(utmp,"RUN")==0) {
-				start=0;
-				ende=ljap->leny-1;
-			} else {
-				if (sscanf(&tmp[4],"%i,%i",&start,&ende) != 2) {
-					start=0;
-					ende=ljap->leny-1;
-				}
-			}
-			time_t a,b;
-			a=time(NULL);
-			ljap->calc(start,ende);
-			b=time(NULL);
-			double d=difftime(b,a);
-			printf("Time used %.2lf sec\n",d);
+		} else if (strstr(utmp,"BENCH(")==utmp) {
+			int32_t size,anzt;
+			if (sscanf(&utmp[6],"%i,%i",&size,&anzt) != 2) { printf("Error\n");continue; }
+			benchTemplates(size,anzt,"_bench.json");
+		} else if (strcmp(utmp,"STATS")==0) {
+			ljap->printstats(stdout);
+		} else if (strstr(utmp,"STATS(")==utmp) {
+			ljap->printstats(stdout);
+			ljap->savestatsjson(&tmp[6]);
+		} else if (strstr(utmp,"HEATMAP(")==utmp) {
+			int32_t an;
+			if (sscanf(&utmp[8],"%i",&an) != 1) { printf("Error\n");continue; }
+			ljap->setheatmap(an);
+		} else if (strstr(utmp,"SAVEHEATMAP(")==utmp) {
+			char fn[1024];
+			sprintf(fn,"%s.bmp",&tmp[12]);
+			ljap->saveheatmap(fn);
+		} else if (strcmp(utmp,"PROFILE")==0) {
+			ljap->printprofile(stdout);
+		} else if (strstr(utmp,"PROFILE(")==utmp) {
+			int32_t an;
+			unsigned long long fp=0;
+			int32_t anz=sscanf(&utmp[8],"%i,%llx",&an,&fp);
+			if (anz < 1) { printf("Error\n");continue; }
+			ljap->profiling=an;
+			ljap->perffpraw=fp;
+		} else if (strstr(utmp,"TRACE(")==utmp) {
+			int32_t an;
+			if (sscanf(&utmp[6],"%i",&an) != 1) { printf("Error\n");continue; }
+			setTrace(an);
+		} else if (strstr(utmp,"SAVETRACE(")==utmp) {
+			saveTrace(&tmp[10]);
+		} else if (strcmp(utmp,"ESTIMATE")==0) {
+			int64_t mem,ausgabe;
+			if (ljap->estimate(mem,ausgabe,1) < 0) printf("Nothing to estimate\n");
+		} else if (strstr(utmp,"RUNPROC(")==utmp) {
+			int32_t n,z=PROZZEILEN;
+			if (sscanf(&utmp[8],"%i,%i",&n,&z) < 1) { printf("Error\n");continue; }
+			if (runProc(ljap,n,z) <= 0) { printf("Error: not all rows computed\n"); continue; }
 			sprintf(tmp,"tmpljap.bmp"); ljap->savebmp(tmp,NULL);
 			sprintf(tmp,"tmpljap.par"); ljap->savepar(tmp);
 			sprintf(tmp,"tmpljap.ljd"); ljap->saveexp(tmp);
+		} else if (strstr(utmp,"SEARCH(")==utmp) {
+			int32_t g,p,k,pos=0;
+			if (sscanf(&tmp[7],"%i,%i,%i%n",&g,&p,&k,&pos) != 3) { printf("Error\n");continue; }
+			if (tmp[7+pos]==',') runSearch(ljap,g,p,k,&tmp[8+pos]);
+			else runSearch(ljap,g,p,k,SUCHJOURNAL);
+		} else if (strstr(utmp,"AUTOCOLOR")==utmp) {
+			int32_t n=AUTOINTERVALLE;
+			if ((utmp[9]=='(')&&(sscanf(&utmp[10],"%i",&n) != 1)) { printf("Error\n");continue; }
+			if (ljap->autocolor(n) < 0) printf("Nothing to color\n");
+		} else if (strstr(utmp,"SUPERSAMPLE(")==utmp) {
+			int32_t n,f=AAFARBE;
+			double l=AALAMBDA;
+			if (sscanf(&utmp[12],"%i,%lf,%i",&n,&l,&f) < 1) { printf("Error\n");continue; }
+			ljap->setsupersample(n,l,f);
+		} else if (strstr(utmp,"GATE(")==utmp) {
+			double w;
+			int32_t d=GATEDIV;
+			if (sscanf(&utmp[5],"%lf,%i",&w,&d) < 1) { printf("Error\n");continue; }
+			ljap->setgate(w,d);
+		} else if (strstr(utmp,"WARMSTART(")==utmp) {
+			int32_t w;
+			if (sscanf(&utmp[10],"%i",&w) != 1) { printf("Error\n");continue; }
+			ljap->warmdiv=(w>0) ? w : 0;
+		} else if (strcmp(utmp,"CHECKWARM")==0) {
+			ljap->checkwarm();
+		} else if (strstr(utmp,"STATE(")==utmp) {
+			int32_t an;
+			if (sscanf(&utmp[6],"%i",&an) != 1) { printf("Error\n");continue; }
+			ljap->setzustand(an);
+		} else if (strstr(utmp,"VIEWPORT(")==utmp) {
+			int32_t an;
+			if (sscanf(&utmp[9],"%i",&an) != 1) { printf("Error\n");continue; }
+			ljap->setviewport(an);
+		} else if (strstr(utmp,"CACHE(")==utmp) {
+			int32_t mb;
+			char dir[1024];
+			int32_t anz=sscanf(&tmp[6],"%i,%1000s",&mb,dir);
+			if (anz < 1) { printf("Error\n");continue; }
+			setCache(mb,(anz==2) ? dir : NULL);
+		} else if (strcmp(utmp,"CACHE")==0) {
+			printf("cache %s, %lli MB, hits %lli misses %lli damaged %lli\n",
+				(cachemax>0) ? cachedir : "off",(long long)(cachemax >> 20),
+				(long long)cachehits,(long long)cachemisses,(long long)cachedefekt);
+		} else if (strstr(utmp,"SETISA(")==utmp) {
+			int32_t i;
+			if (sscanf(&utmp[7],"%i",&i) != 1) { printf("Error\n");continue; }
+			setIsa(i);
+		} else if (strstr(utmp,"SETPRECISION(")==utmp) {
+			int32_t pr;
+			if (sscanf(&utmp[13],"%i",&pr) != 1) { printf("Error\n");continue; }
+			ljap->setprecision(pr);
+		} else if (strcmp(utmp,"CHECKPRECISION")==0) {
+			ljap->checkprecision();
+		} else if (strstr(utmp,"SETTHREADS(")==utmp) {
+			int32_t n;
+			if (sscanf(&utmp[11],"%i",&n) != 1) { printf("Error\n");continue; }
+			ljap->setthreads(n);
+		} else if (strcmp(utmp,"BENCHFORMULA")==0) {
+			benchFormula(ljap);
+		} else if (strstr(utmp,"ASYNC(")==utmp) {
+			int32_t an;
+			if (sscanf(&utmp[6],"%i",&an) != 1) { printf("Error\n");continue; }
+			async=an;
+		} else if (strcmp(utmp,"STATUS")==0) {
+			if (menujob.laeuft) printf("job %s running %.1lf sec, calc %i of %i done%s\n",
+				menujob.utmp,(nanosec()-menujob.t0)*1E-9,
+				(int32_t)ljap->fortschritt,(int32_t)ljap->fortschrittanz,
+				(ljap->abbruch) ? ", cancelling" : "");
+			else printf("No job running\n");
+		} else if (strcmp(utmp,"CANCEL")==0) {
+			if (menujob.laeuft) ljap->abbruch=1;
+			else printf("No job running\n");
+		} else if (strcmp(utmp,"WAIT")==0) {
+			if (menuJobEnde(1) <= 0) printf("No job running\n");
+		} else if (menuJobBefehl(utmp)) {
+			menuJobStart(tmp,utmp);
 		}
 	} // while
 